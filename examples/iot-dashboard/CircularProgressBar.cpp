@@ -4,13 +4,19 @@
  *****************************************************************************/
 
 #include "CircularProgressBar.h"
+#include "nodes/CircularProgressBarNode.h"
 
-#include <QPainter>
+#include <QskTextureRenderer.h>
+
+#include <QQuickWindow>
+#include <QtMath>
 
 CircularProgressBar::CircularProgressBar( const QskGradient& gradient, int progress, QQuickItem* parent )
-    : QQuickPaintedItem( parent )
+    : QQuickItem( parent )
     , m_progress( progress )
 {
+    setFlag( QQuickItem::ItemHasContents, true );
+
     // This is a bit hackish, but let's do this properly
     // once QSkinny has an arc renderer in place
     QLinearGradient g( 0, 0, 30, 0 );
@@ -19,38 +25,61 @@ CircularProgressBar::CircularProgressBar( const QskGradient& gradient, int progr
     g.setStops( {stop1, stop2} );
     m_gradient = g;
 
-    connect( this, &QQuickPaintedItem::contentsSizeChanged, [this]()
+    const auto updateRingGradient = [this]()
     {
-        auto size = contentsSize();
-        QRadialGradient ringGradient( size.width() / 2, size.height() / 2, 45 );
+        QRadialGradient ringGradient( QQuickItem::width() / 2, QQuickItem::height() / 2, 45 );
         QGradientStop stop1( 0.0, "#c0c0c0" );
         QGradientStop stop2( 0.5, "#f0f0f0" );
         QGradientStop stop3( 1.0, "#c0c0c0" );
         ringGradient.setStops( {stop1, stop2, stop3} );
 
         m_ringGradient = ringGradient;
-    } );
+    };
+
+    connect( this, &QQuickItem::widthChanged, updateRingGradient );
+    connect( this, &QQuickItem::heightChanged, updateRingGradient );
 }
 
-void CircularProgressBar::paint( QPainter* painter )
+void CircularProgressBar::setProgress( int progress )
 {
-    auto size = contentsSize();
-    QRectF outerRect( {0, 0}, size );
+    if( progress != m_progress )
+    {
+        m_progress = progress;
+        update();
+    }
+}
 
-    painter->setRenderHint( QPainter::Antialiasing, true );
+QSGNode* CircularProgressBar::updatePaintNode( QSGNode* node, QQuickItem::UpdatePaintNodeData* data )
+{
+    Q_UNUSED( data );
 
-    painter->setBrush( m_ringGradient );
-    painter->setPen( m_backgroundColor );
-    painter->drawEllipse( outerRect );
+    const QRect rect( 0, 0, qCeil( QQuickItem::width() ), qCeil( QQuickItem::height() ) );
+
+    if( rect.isEmpty() )
+    {
+        delete node;
+        return nullptr;
+    }
+
+    auto progressNode = static_cast<CircularProgressBarNode*>( node );
+
+    if( !progressNode )
+    {
+        progressNode = new CircularProgressBarNode();
+    }
 
-    int startAngle = 1440;
-    int endAngle = -16 * ( m_progress / 100.0 ) * 360;
+    progressNode->setProgress( m_progress );
+    progressNode->setWidth( m_width );
+    progressNode->setBackgroundColor( m_backgroundColor );
+    progressNode->setGradient( m_gradient );
+    progressNode->setRingGradient( m_ringGradient );
 
-    painter->setBrush( m_gradient );
-    painter->drawPie( outerRect, startAngle, endAngle );
+    /*
+        We keep a copy of the image with the raster paint engine,
+        so that changing the progress only repaints and uploads
+        the sector in between the old and the new value.
+     */
+    progressNode->update( window(), QskTextureRenderer::Raster, rect );
 
-    painter->setBrush( m_backgroundColor );
-    painter->setPen( m_backgroundColor );
-    QRectF innerRect( width() / 2, width() / 2, size.width() - width(), size.height() - width() );
-    painter->drawEllipse( innerRect );
+    return progressNode;
 }
@@ -9,14 +9,19 @@
 #include <QskGradient.h>
 
 #include <QGradient>
-#include <QQuickPaintedItem>
+#include <QQuickItem>
 
-class CircularProgressBar : public QQuickPaintedItem
+class CircularProgressBar : public QQuickItem
 {
     public:
         CircularProgressBar( const QskGradient& gradient, int progress, QQuickItem* parent = nullptr );
 
-        virtual void paint( QPainter* painter ) override;
+        int progress() const
+        {
+            return m_progress;
+        }
+
+        void setProgress( int progress );
 
         double width() const
         {
@@ -48,6 +53,9 @@ class CircularProgressBar : public QQuickPaintedItem
             m_ringGradient = gradient;
         }
 
+    protected:
+        QSGNode* updatePaintNode( QSGNode* node, QQuickItem::UpdatePaintNodeData* data ) override;
+
     private:
         QGradient m_gradient;
         QColor m_backgroundColor;
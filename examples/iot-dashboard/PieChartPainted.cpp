@@ -15,8 +15,8 @@
 
 #include <QFontMetricsF>
 #include <QGuiApplication>
-#include <QQuickPaintedItem>
 #include <QQuickWindow>
+#include <QVariantAnimation>
 
 QSK_SUBCONTROL( PieChartPainted, Panel )
 
@@ -89,8 +89,6 @@ PieChartPainted::PieChartPainted( const QColor& color, const QskGradient& gradie
 {
     setAutoLayoutChildren( true );
 
-    auto progressText = QString::number( progress ) + " %";
-    m_progressLabel->setText( progressText );
     m_progressLabel->setFontRole( QskSkin::SmallFont );
     m_progressLabel->setTextColor( color );
 
@@ -101,6 +99,31 @@ PieChartPainted::PieChartPainted( const QColor& color, const QskGradient& gradie
     {
         m_animator->start();
     } );
+
+    setProgress( 0 );
+
+    // the progress bar repaints only the sector, that has changed
+    auto progressAnimation = new QVariantAnimation( this );
+    progressAnimation->setDuration( 1000 );
+    progressAnimation->setStartValue( 0 );
+    progressAnimation->setEndValue( progress );
+
+    connect( progressAnimation, &QVariantAnimation::valueChanged, [this]( const QVariant& value )
+    {
+        setProgress( value.toInt() );
+    } );
+
+    progressAnimation->start( QAbstractAnimation::DeleteWhenStopped );
+}
+
+void PieChartPainted::setProgress( int progress )
+{
+    m_progressBar->setProgress( progress );
+
+    auto progressText = QString::number( progress ) + " %";
+    m_progressLabel->setText( progressText );
+
+    polish();
 }
 
 QskAspect::Subcontrol PieChartPainted::effectiveSubcontrol( QskAspect::Subcontrol subControl ) const
@@ -120,7 +143,7 @@ QSizeF PieChartPainted::contentsSizeHint( Qt::SizeHint /*sizeHint*/, const QSize
 
 void PieChartPainted::updateLayout()
 {
-    m_progressBar->setContentsSize( size().toSize() );
+    m_progressBar->setSize( size() );
     m_progressBar->update();
 
     const auto rect = layoutRect();
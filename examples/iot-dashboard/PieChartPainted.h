@@ -13,7 +13,6 @@
 class ProgressBarAnimator;
 
 class QskTextLabel;
-class QQuickPaintedItem;
 
 class PieChartPainted : public QskControl
 {
@@ -28,6 +27,8 @@ class PieChartPainted : public QskControl
         virtual QSizeF contentsSizeHint( Qt::SizeHint, const QSizeF& ) const override;
         void updateLayout() override;
 
+        void setProgress( int progress );
+
     private:
         QColor m_color;
         QskGradient m_gradient;
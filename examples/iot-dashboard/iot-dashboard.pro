@@ -23,6 +23,7 @@ SOURCES += \
     UsageDiagram.cpp
 
 SOURCES += \
+    nodes/CircularProgressBarNode.cpp \
     nodes/DiagramDataNode.cpp \
     nodes/DiagramSegmentsNode.cpp
 
@@ -48,6 +49,7 @@ HEADERS += \
     UsageDiagram.h
 
 HEADERS += \
+    nodes/CircularProgressBarNode.h \
     nodes/DiagramDataNode.h \
     nodes/DiagramSegmentsNode.h
 
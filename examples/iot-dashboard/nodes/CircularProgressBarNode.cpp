@@ -0,0 +1,138 @@
+/******************************************************************************
+ * Copyright (C) 2021 Edelhirsch Software GmbH
+ * This file may be used under the terms of the 3-clause BSD License
+ *****************************************************************************/
+
+#include "CircularProgressBarNode.h"
+
+#include <QPainter>
+#include <QPolygonF>
+#include <QtMath>
+
+namespace
+{
+    uint gradientHash( const QGradient& gradient, uint seed )
+    {
+        uint hash = qHash( int( gradient.type() ), seed );
+
+        for( const auto& stop : gradient.stops() )
+        {
+            hash = qHash( stop.first, hash );
+            hash = qHash( stop.second.rgba(), hash );
+        }
+
+        return hash;
+    }
+
+    // angle in degrees, counterclockwise starting at 3 o'clock
+    qreal progressAngle( qreal progress )
+    {
+        return 90.0 - 3.6 * progress;
+    }
+}
+
+CircularProgressBarNode::CircularProgressBarNode()
+{
+}
+
+void CircularProgressBarNode::setProgress( int progress )
+{
+    m_progress = progress;
+}
+
+void CircularProgressBarNode::setWidth( qreal width )
+{
+    m_width = width;
+}
+
+void CircularProgressBarNode::setBackgroundColor( const QColor& color )
+{
+    m_backgroundColor = color;
+}
+
+void CircularProgressBarNode::setGradient( const QGradient& gradient )
+{
+    m_gradient = gradient;
+}
+
+void CircularProgressBarNode::setRingGradient( const QRadialGradient& gradient )
+{
+    m_ringGradient = gradient;
+}
+
+void CircularProgressBarNode::paint( QPainter* painter, const QSizeF& size )
+{
+    const QRectF outerRect( { 0, 0 }, size );
+
+    painter->setRenderHint( QPainter::Antialiasing, true );
+
+    painter->setBrush( m_ringGradient );
+    painter->setPen( m_backgroundColor );
+    painter->drawEllipse( outerRect );
+
+    const int startAngle = 1440;
+    const int endAngle = -16 * ( m_progress / 100.0 ) * 360;
+
+    painter->setBrush( m_gradient );
+    painter->drawPie( outerRect, startAngle, endAngle );
+
+    painter->setBrush( m_backgroundColor );
+    painter->setPen( m_backgroundColor );
+
+    const QRectF innerRect( m_width / 2, m_width / 2,
+        size.width() - m_width, size.height() - m_width );
+    painter->drawEllipse( innerRect );
+
+    m_paintedProgress = m_progress;
+    m_paintedHash = appearanceHash();
+}
+
+uint CircularProgressBarNode::hash()
+{
+    return qHash( m_progress, appearanceHash() );
+}
+
+QRegion CircularProgressBarNode::dirtyRegion( const QSize& size )
+{
+    if( m_paintedProgress < 0 || m_paintedHash != appearanceHash() )
+        return QRegion(); // everything
+
+    const QPointF center( 0.5 * size.width(), 0.5 * size.height() );
+
+    const qreal from = progressAngle( qMin( m_progress, m_paintedProgress ) );
+    const qreal to = progressAngle( qMax( m_progress, m_paintedProgress ) );
+
+    // the sector between the old and the new progress
+    QPolygonF sector;
+    sector += center;
+
+    for( qreal angle = from; ; angle -= 5.0 )
+    {
+        angle = qMax( angle, to );
+
+        const qreal radians = qDegreesToRadians( angle );
+
+        sector += QPointF( center.x() + center.x() * qCos( radians ),
+            center.y() - center.y() * qSin( radians ) );
+
+        if( angle <= to )
+            break;
+    }
+
+    // some extra pixels for the antialiased edges
+    return sector.boundingRect().toAlignedRect().adjusted( -2, -2, 2, 2 );
+}
+
+uint CircularProgressBarNode::appearanceHash() const
+{
+    uint hash = qHash( m_width );
+    hash = qHash( m_backgroundColor.rgba(), hash );
+    hash = gradientHash( m_gradient, hash );
+
+    hash = gradientHash( m_ringGradient, hash );
+    hash = qHash( m_ringGradient.center().x(), hash );
+    hash = qHash( m_ringGradient.center().y(), hash );
+    hash = qHash( m_ringGradient.radius(), hash );
+
+    return hash;
+}
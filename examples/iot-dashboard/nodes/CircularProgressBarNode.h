@@ -0,0 +1,46 @@
+/******************************************************************************
+ * Copyright (C) 2021 Edelhirsch Software GmbH
+ * This file may be used under the terms of the 3-clause BSD License
+ *****************************************************************************/
+
+#ifndef CIRCULARPROGRESSBARNODE_H
+#define CIRCULARPROGRESSBARNODE_H
+
+#include <QskPaintedNode.h>
+
+#include <QColor>
+#include <QGradient>
+
+class CircularProgressBarNode : public QskPaintedNode
+{
+    public:
+        CircularProgressBarNode();
+
+        void setProgress( int progress );
+        void setWidth( qreal width );
+        void setBackgroundColor( const QColor& color );
+        void setGradient( const QGradient& gradient );
+        void setRingGradient( const QRadialGradient& gradient );
+
+    protected:
+        void paint( QPainter* painter, const QSizeF& size ) override;
+        uint hash() override;
+
+        // when only the progress has changed we repaint the affected sector
+        QRegion dirtyRegion( const QSize& size ) override;
+
+    private:
+        uint appearanceHash() const;
+
+        int m_progress = 0;
+        qreal m_width = 20;
+        QColor m_backgroundColor;
+        QGradient m_gradient;
+        QRadialGradient m_ringGradient;
+
+        // what is in the texture
+        int m_paintedProgress = -1;
+        uint m_paintedHash = 0;
+};
+
+#endif
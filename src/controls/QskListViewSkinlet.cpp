@@ -8,6 +8,7 @@
 
 #include "QskColorFilter.h"
 #include "QskGraphic.h"
+#include "QskNodePool.h"
 #include "QskSGNode.h"
 
 #include <qmath.h>
@@ -300,7 +301,7 @@ void QskListViewSkinlet::updateVisibleForegroundNodes(
     if ( forward )
     {
         for ( int i = 0; i < obsoleteNodesCount; i++ )
-            delete parentNode->lastChild();
+            QskNodePool::releaseNode( listView->window(), parentNode->lastChild() );
 
         auto node = parentNode->firstChild();
 
@@ -323,7 +324,7 @@ void QskListViewSkinlet::updateVisibleForegroundNodes(
     else
     {
         for ( int i = 0; i < obsoleteNodesCount; i++ )
-            delete parentNode->firstChild();
+            QskNodePool::releaseNode( listView->window(), parentNode->firstChild() );
 
         auto* node = parentNode->lastChild();
 
@@ -351,6 +352,8 @@ QSGTransformNode* QskListViewSkinlet::updateForegroundNode(
 {
     const QRectF cellRect( 0.0, 0.0, size.width(), size.height() );
 
+    const auto window = listView->window();
+
     /*
         Text nodes already have a transform root node - to avoid inserting extra
         transform nodes, the code below becomes a bit more complicated.
@@ -370,7 +373,7 @@ QSGTransformNode* QskListViewSkinlet::updateForegroundNode(
             }
             else
             {
-                newCellNode = new QSGTransformNode();
+                newCellNode = QskNodePool::acquireNode< QSGTransformNode >( window );
                 newCellNode->appendChildNode( newNode );
             }
         }
@@ -390,14 +393,14 @@ QSGTransformNode* QskListViewSkinlet::updateForegroundNode(
             {
                 if ( cellNode == nullptr )
                 {
-                    newCellNode = new QSGTransformNode();
+                    newCellNode = QskNodePool::acquireNode< QSGTransformNode >( window );
                     newCellNode->appendChildNode( newNode );
                 }
                 else
                 {
                     if ( newNode != oldNode )
                     {
-                        delete cellNode->firstChild();
+                        QskNodePool::releaseNode( window, cellNode->firstChild() );
                         cellNode->appendChildNode( newNode );
 
                         newCellNode = cellNode;
@@ -408,14 +411,14 @@ QSGTransformNode* QskListViewSkinlet::updateForegroundNode(
     }
 
     if ( newCellNode == nullptr )
-        newCellNode = new QSGTransformNode();
+        newCellNode = QskNodePool::acquireNode< QSGTransformNode >( window );
 
     if ( cellNode != newCellNode )
     {
         if ( cellNode )
         {
             parentNode->insertChildNodeAfter( newCellNode, cellNode );
-            delete cellNode;
+            QskNodePool::releaseNode( window, cellNode );
         }
         else
         {
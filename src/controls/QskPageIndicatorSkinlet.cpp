@@ -7,6 +7,7 @@
 #include "QskPageIndicator.h"
 
 #include "QskBoxNode.h"
+#include "QskNodePool.h"
 #include "QskSGNode.h"
 
 QskPageIndicatorSkinlet::QskPageIndicatorSkinlet( QskSkin* skin )
@@ -155,14 +156,32 @@ QSGNode* QskPageIndicatorSkinlet::updateBulletsNode(
         if ( i > 0 )
             bulletNode = bulletNode->nextSibling();
 
-        if ( bulletNode == nullptr )
-            bulletNode = new QskBoxNode();
-
-        updateBoxNode( indicator, bulletNode, bulletRect( indicator, rect, i ),
+        /*
+            The node might be replaced by updateBoxNode, f.e. when
+            the software backend is in use. As invisible bullets
+            still need a placeholder we fall back to an empty box node.
+         */
+        auto newNode = updateBoxNode( indicator, bulletNode,
+            bulletRect( indicator, rect, i ),
             ( i == currentBullet ) ? Q::Highlighted : Q::Bullet );
 
-        if ( bulletNode->parent() != node )
-            node->appendChildNode( bulletNode );
+        if ( newNode == nullptr )
+            newNode = bulletNode ? bulletNode : new QskBoxNode();
+
+        if ( newNode != bulletNode )
+        {
+            if ( bulletNode )
+            {
+                node->insertChildNodeAfter( newNode, bulletNode );
+                QskNodePool::releaseNode( indicator->window(), bulletNode );
+            }
+            else
+            {
+                node->appendChildNode( newNode );
+            }
+
+            bulletNode = newNode;
+        }
     }
 
     // if count has decreased we need to remove superfluous nodes
@@ -46,8 +46,12 @@ class QSK_EXPORT QskQuickItem : public QQuickItem
         CleanupOnVisibility     =  1 << 3,
 
         PreferRasterForTextures =  1 << 4,
+        AsyncRasterForTextures  =  1 << 5,
+        PreferVectorGraphics    =  1 << 6,
 
-        DebugForceBackground    =  1 << 7
+        DebugForceBackground    =  1 << 7,
+
+        RasterLevelsForTextures =  1 << 8
     };
 
     Q_ENUM( UpdateFlag )
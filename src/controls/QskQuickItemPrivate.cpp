@@ -65,8 +65,8 @@ void QskQuickItemPrivate::applyUpdateFlags( QskQuickItem::UpdateFlags flags )
 
     Q_Q( QskQuickItem );
 
-    Q_STATIC_ASSERT( sizeof( updateFlags ) == 1 );
-    for ( uint i = 0; i < 8; i++ )
+    Q_STATIC_ASSERT( sizeof( updateFlags ) == 2 );
+    for ( uint i = 0; i < 16; i++ )
     {
         const auto flag = static_cast< QskQuickItem::UpdateFlag >( 1 << i );
 
@@ -49,8 +49,8 @@ class QskQuickItemPrivate : public QQuickItemPrivate
   private:
     Q_DECLARE_PUBLIC( QskQuickItem )
 
-    quint8 updateFlags;
-    quint8 updateFlagsMask;
+    quint16 updateFlags;
+    quint16 updateFlagsMask;
 
     bool polishOnResize : 1;
 
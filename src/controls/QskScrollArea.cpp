@@ -136,30 +136,20 @@ namespace
                 isDirty = true;
             }
 
-            if ( other->isRectangular() )
+            if ( isRectangular() != other->isRectangular() )
             {
-                if ( !isRectangular() )
-                {
-                    setIsRectangular( true );
-                    setGeometry( nullptr );
-
-                    isDirty = true;
-                }
+                setIsRectangular( other->isRectangular() );
+                isDirty = true;
             }
-            else
-            {
-                if ( isRectangular() )
-                {
-                    setIsRectangular( false );
-                    isDirty = true;
-                }
 
-                if ( geometry() != other->geometry() )
-                {
-                    // both nodes share the same geometry
-                    setGeometry( const_cast< QSGGeometry* >( other->geometry() ) );
-                    isDirty = true;
-                }
+            if ( geometry() != other->geometry() )
+            {
+                /*
+                    both nodes share the same geometry, that is also
+                    needed for rectangular clips, when being rotated
+                 */
+                setGeometry( const_cast< QSGGeometry* >( other->geometry() ) );
+                isDirty = true;
             }
 
             if ( isDirty )
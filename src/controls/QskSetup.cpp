@@ -38,6 +38,15 @@ static inline const QskQuickItem::UpdateFlags qskEnvironmentUpdateFlags()
     if ( qskHasEnvironment( "QSK_PREFER_RASTER" ) )
         flags |= QskQuickItem::PreferRasterForTextures;
 
+    if ( qskHasEnvironment( "QSK_ASYNC_RASTER" ) )
+        flags |= QskQuickItem::AsyncRasterForTextures;
+
+    if ( qskHasEnvironment( "QSK_RASTER_LEVELS" ) )
+        flags |= QskQuickItem::RasterLevelsForTextures;
+
+    if ( qskHasEnvironment( "QSK_PREFER_VECTOR" ) )
+        flags |= QskQuickItem::PreferVectorGraphics;
+
     if ( qskHasEnvironment( "QSK_FORCE_BACKGROUND" ) )
         flags |= QskQuickItem::DebugForceBackground;
 
@@ -17,14 +17,25 @@
 #include "QskGradient.h"
 #include "QskGraphicNode.h"
 #include "QskGraphic.h"
+#include "QskMergedBoxNode.h"
+#include "QskNodePool.h"
+#include "QskNodeStatistics.h"
 #include "QskSGNode.h"
+#include "QskSoftwareBoxNode.h"
 #include "QskTextColors.h"
 #include "QskTextNode.h"
 #include "QskTextOptions.h"
+#include "QskVectorGraphicNode.h"
 
 #include <qquickwindow.h>
 #include <qsgsimplerectnode.h>
 
+static inline QQuickWindow* qskWindow( const QskSkinnable* skinnable )
+{
+    const auto control = skinnable->owningControl();
+    return control ? control->window() : nullptr;
+}
+
 static inline QRectF qskSubControlRect( const QskSkinlet* skinlet,
     const QskSkinnable* skinnable, QskAspect::Subcontrol subControl )
 {
@@ -49,15 +60,44 @@ static inline QSGNode* qskUpdateGraphicNode(
     if ( control == nullptr )
         return nullptr;
 
+    if ( control->testUpdateFlag( QskControl::PreferVectorGraphics )
+        && QskVectorGraphicNode::isSupported( graphic ) )
+    {
+        auto vectorNode = dynamic_cast< QskVectorGraphicNode* >( node );
+        if ( vectorNode == nullptr )
+            vectorNode = new QskVectorGraphicNode();
+
+        // no texture, no need to align the rect to pixels
+        vectorNode->setGraphic( control->window(),
+            graphic, colorFilter, rect, mirrored );
+
+        return vectorNode;
+    }
+
     auto mode = QskTextureRenderer::OpenGL;
 
-    auto graphicNode = static_cast< QskGraphicNode* >( node );
-    if ( graphicNode == nullptr )
+    QskGraphicNode* graphicNode = nullptr;
+
+    // the flags might have changed since the node has been created
+    if ( node && node->type() == QSGNode::GeometryNodeType )
+        graphicNode = static_cast< QskGraphicNode* >( node );
+    else
         graphicNode = new QskGraphicNode();
 
     if ( control->testUpdateFlag( QskControl::PreferRasterForTextures ) )
         mode = QskTextureRenderer::Raster;
 
+    if ( control->testUpdateFlag( QskControl::AsyncRasterForTextures ) )
+        mode = QskTextureRenderer::AsyncRaster;
+
+    const bool rasterLevels =
+        control->testUpdateFlag( QskControl::RasterLevelsForTextures );
+
+    if ( rasterLevels )
+        mode = QskTextureRenderer::AsyncRaster;
+
+    graphicNode->setRasterLevels( rasterLevels );
+
     /*
        Aligning the rect according to scene coordinates, so that
        we don't run into rounding issues downstream, where values
@@ -77,6 +117,42 @@ static inline QSGNode* qskUpdateGraphicNode(
     return graphicNode;
 }
 
+static inline QSGNode* qskUpdateBoxNode( QQuickWindow* window, QSGNode* node,
+    const QRectF& rect, const QskBoxShapeMetrics& shape,
+    const QskBoxBorderMetrics& borderMetrics, const QskBoxBorderColors& borderColors,
+    const QskGradient& gradient )
+{
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 8, 0 )
+    if ( QskSoftwareBoxNode::isRequired( window ) )
+    {
+        QskSoftwareBoxNode* softwareNode;
+
+        if ( node && node->type() == QSGNode::RenderNodeType )
+            softwareNode = static_cast< QskSoftwareBoxNode* >( node );
+        else
+            softwareNode = QskNodePool::acquireNode< QskSoftwareBoxNode >( window );
+
+        softwareNode->setBoxData( window, rect,
+            shape, borderMetrics, borderColors, gradient );
+
+        return softwareNode;
+    }
+#endif
+
+    /*
+        The backend might have changed since the node has been created,
+        or the node is a QskMergedBoxNode, when the skinlet has started
+        merging its boxes.
+     */
+    auto boxNode = dynamic_cast< QskBoxNode* >( node );
+    if ( boxNode == nullptr )
+        boxNode = QskNodePool::acquireNode< QskBoxNode >( window );
+
+    boxNode->setBoxData( rect, shape, borderMetrics, borderColors, gradient );
+
+    return boxNode;
+}
+
 static inline bool qskIsBoxVisible( const QskBoxBorderMetrics& borderMetrics,
     const QskBoxBorderColors& borderColors, const QskGradient& gradient )
 {
@@ -86,6 +162,32 @@ static inline bool qskIsBoxVisible( const QskBoxBorderMetrics& borderMetrics,
     return !borderMetrics.isNull() && borderColors.isVisible();
 }
 
+static bool qskBoxHints( const QskSkinnable* skinnable,
+    const QRectF& rect, const QskGradient& fillGradient,
+    QskAspect::Subcontrol subControl, QskMergedBoxNode::Box& box )
+{
+    const auto margins = skinnable->marginHint( subControl );
+
+    box.rect = rect.marginsRemoved( margins );
+    if ( box.rect.isEmpty() )
+        return false;
+
+    box.borderMetrics = skinnable->boxBorderMetricsHint( subControl );
+    box.borderMetrics = box.borderMetrics.toAbsolute( box.rect.size() );
+
+    box.borderColors = skinnable->boxBorderColorsHint( subControl );
+
+    if ( !qskIsBoxVisible( box.borderMetrics, box.borderColors, fillGradient ) )
+        return false;
+
+    box.shape = skinnable->boxShapeHint( subControl );
+    box.shape = box.shape.toAbsolute( box.rect.size() );
+
+    box.gradient = fillGradient;
+
+    return true;
+}
+
 static inline QskTextColors qskTextColors(
     const QskSkinnable* skinnable, QskAspect::Subcontrol subControl )
 {
@@ -109,6 +211,17 @@ static inline QskTextColors qskTextColors(
     return c;
 }
 
+static inline void qskReleaseNode( QQuickWindow* window,
+    QSGNode*& oldNode, const QSGNode* newNode )
+{
+    // passing obsolete nodes to the pool instead of deleting them
+    if ( oldNode && oldNode != newNode )
+    {
+        QskNodePool::releaseNode( window, oldNode );
+        oldNode = nullptr;
+    }
+}
+
 class QskSkinlet::PrivateData
 {
   public:
@@ -167,6 +280,15 @@ void QskSkinlet::updateNode( QskSkinnable* skinnable, QSGNode* parentNode ) cons
 {
     using namespace QskSGNode;
 
+    const auto owningControl = skinnable->owningControl();
+
+    // what happens below is assigned to the class of the control
+    const QskNodeStatistics::Scope statisticsScope(
+        owningControl ? owningControl->window() : nullptr,
+        owningControl ? owningControl->metaObject()->className() : nullptr );
+
+    QskNodeStatistics::increment( QskNodeStatistics::NodeUpdates );
+
     QSGNode* oldNode;
     QSGNode* newNode;
 
@@ -180,6 +302,7 @@ void QskSkinlet::updateNode( QskSkinnable* skinnable, QSGNode* parentNode ) cons
         if ( control->autoFillBackground() )
             newNode = updateBackgroundNode( control, oldNode );
 
+        qskReleaseNode( control->window(), oldNode, newNode );
         replaceChildNode( BackgroundRole, parentNode, oldNode, newNode );
 
         // debug
@@ -190,9 +313,12 @@ void QskSkinlet::updateNode( QskSkinnable* skinnable, QSGNode* parentNode ) cons
         if ( control->testUpdateFlag( QskQuickItem::DebugForceBackground ) )
             newNode = updateDebugNode( control, oldNode );
 
+        qskReleaseNode( control->window(), oldNode, newNode );
         replaceChildNode( DebugRole, parentNode, oldNode, newNode );
     }
 
+    const auto window = qskWindow( skinnable );
+
     for ( int i = 0; i < m_data->nodeRoles.size(); i++ )
     {
         const auto nodeRole = m_data->nodeRoles[ i ];
@@ -202,6 +328,7 @@ void QskSkinlet::updateNode( QskSkinnable* skinnable, QSGNode* parentNode ) cons
         oldNode = QskSGNode::findChildNode( parentNode, nodeRole );
         newNode = updateSubNode( skinnable, nodeRole, oldNode );
 
+        qskReleaseNode( window, oldNode, newNode );
         replaceChildNode( nodeRole, parentNode, oldNode, newNode );
     }
 }
@@ -217,12 +344,8 @@ QSGNode* QskSkinlet::updateBackgroundNode(
     if ( !gradient.isValid() )
         return nullptr;
 
-    auto boxNode = static_cast< QskBoxNode* >( node );
-    if ( boxNode == nullptr )
-        boxNode = new QskBoxNode();
-
-    boxNode->setBoxData( rect, gradient );
-    return boxNode;
+    return qskUpdateBoxNode( control->window(), node, rect,
+        QskBoxShapeMetrics(), QskBoxBorderMetrics(), QskBoxBorderColors(), gradient );
 }
 
 QSGNode* QskSkinlet::updateDebugNode(
@@ -287,30 +410,91 @@ QSGNode* QskSkinlet::updateBoxNode( const QskSkinnable* skinnable,
     QSGNode* node, const QRectF& rect, const QskGradient& fillGradient,
     QskAspect::Subcontrol subControl )
 {
-    const auto margins = skinnable->marginHint( subControl );
-
-    const auto boxRect = rect.marginsRemoved( margins );
-    if ( boxRect.isEmpty() )
+    QskMergedBoxNode::Box box;
+    if ( !qskBoxHints( skinnable, rect, fillGradient, subControl, box ) )
         return nullptr;
 
-    auto borderMetrics = skinnable->boxBorderMetricsHint( subControl );
-    borderMetrics = borderMetrics.toAbsolute( boxRect.size() );
+    return qskUpdateBoxNode( qskWindow( skinnable ), node, box.rect,
+        box.shape, box.borderMetrics, box.borderColors, box.gradient );
+}
 
-    const auto borderColors = skinnable->boxBorderColorsHint( subControl );
+QSGNode* QskSkinlet::updateMergedBoxNode( const QskSkinnable* skinnable,
+    QSGNode* node, const QVector< QskAspect::Subcontrol >& subControls ) const
+{
+    const auto window = qskWindow( skinnable );
 
-    if ( !qskIsBoxVisible( borderMetrics, borderColors, fillGradient ) )
-        return nullptr;
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 8, 0 )
+    if ( QskSoftwareBoxNode::isRequired( window ) )
+    {
+        // no geometry nodes: falling back to a node for each box
 
-    auto shape = skinnable->boxShapeHint( subControl );
-    shape = shape.toAbsolute( boxRect.size() );
+        QVector< QSGNode* > oldNodes;
 
-    auto boxNode = static_cast< QskBoxNode* >( node );
-    if ( boxNode == nullptr )
-        boxNode = new QskBoxNode();
+        if ( node && node->type() == QSGNode::BasicNodeType )
+        {
+            while ( auto childNode = node->firstChild() )
+            {
+                node->removeChildNode( childNode );
+                oldNodes += childNode;
+            }
+        }
+        else
+        {
+            // the caller releases a node of a different type
+            node = nullptr;
+        }
 
-    boxNode->setBoxData( boxRect, shape, borderMetrics, borderColors, fillGradient );
+        for ( const auto subControl : subControls )
+        {
+            auto oldNode = oldNodes.isEmpty() ? nullptr : oldNodes.takeFirst();
 
-    return boxNode;
+            auto newNode = updateBoxNode( skinnable, oldNode, subControl );
+            if ( newNode )
+            {
+                // created only, when having a box to display
+                if ( node == nullptr )
+                    node = new QSGNode();
+
+                node->appendChildNode( newNode );
+            }
+
+            qskReleaseNode( window, oldNode, newNode );
+        }
+
+        for ( auto oldNode : qskAsConst( oldNodes ) )
+            QskNodePool::releaseNode( window, oldNode );
+
+        // an existing node without children is released by the caller
+        return ( node && node->firstChild() ) ? node : nullptr;
+    }
+#endif
+
+    QVector< QskMergedBoxNode::Box > boxes;
+    boxes.reserve( subControls.count() );
+
+    for ( const auto subControl : subControls )
+    {
+        const auto rect = qskSubControlRect( this, skinnable, subControl );
+
+        QskMergedBoxNode::Box box;
+        if ( qskBoxHints( skinnable, rect,
+            skinnable->gradientHint( subControl ), subControl, box ) )
+        {
+            boxes += box;
+        }
+    }
+
+    if ( boxes.isEmpty() )
+        return nullptr;
+
+    // the node might be a QskBoxNode, when the skinlet has stopped merging
+    auto mergedNode = dynamic_cast< QskMergedBoxNode* >( node );
+    if ( mergedNode == nullptr )
+        mergedNode = QskNodePool::acquireNode< QskMergedBoxNode >( window );
+
+    mergedNode->setBoxes( boxes );
+
+    return mergedNode;
 }
 
 QSGNode* QskSkinlet::updateBoxClipNode( const QskSkinnable* skinnable,
@@ -332,8 +516,7 @@ QSGNode* QskSkinlet::updateBoxClipNode( const QskSkinnable* skinnable,
     const auto clipRect = rect.marginsRemoved( margins );
     if ( clipRect.isEmpty() )
     {
-        clipNode->setIsRectangular( true );
-        clipNode->setClipRect( clipRect );
+        clipNode->setBox( clipRect, QskBoxShapeMetrics(), QskBoxBorderMetrics() );
     }
     else
     {
@@ -360,7 +543,7 @@ QSGNode* QskSkinlet::updateTextNode(
 
     auto textNode = static_cast< QskTextNode* >( node );
     if ( textNode == nullptr )
-        textNode = new QskTextNode();
+        textNode = QskNodePool::acquireNode< QskTextNode >( qskWindow( skinnable ) );
 
     const auto colors = qskTextColors( skinnable, subControl );
 
@@ -88,6 +88,13 @@ class QSK_EXPORT QskSkinlet
     QSGNode* updateBoxClipNode( const QskSkinnable*, QSGNode*,
         QskAspect::Subcontrol ) const;
 
+    /*
+        Boxes of several subcontrols with one geometry node. The boxes
+        have to be next to each other in the stacking order.
+     */
+    QSGNode* updateMergedBoxNode( const QskSkinnable*, QSGNode*,
+        const QVector< QskAspect::Subcontrol >& ) const;
+
     QSGNode* updateTextNode( const QskSkinnable*, QSGNode*,
         const QString&, const QskTextOptions&, QskAspect::Subcontrol ) const;
 
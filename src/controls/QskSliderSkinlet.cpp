@@ -28,8 +28,27 @@ static inline QRectF qskInnerPanelRect(
     return r;
 }
 
+static inline bool qskIsMergingBoxes( const QskSliderSkinlet* skinlet )
+{
+    using S = QskSliderSkinlet;
+
+    if ( !skinlet->isMergingBoxes() )
+        return false;
+
+    /*
+        All boxes of a slider can be drawn by one geometry node,
+        as long as the roles have not been modified by a derived skinlet.
+     */
+    const auto& roles = skinlet->nodeRoles();
+
+    return ( roles.count() == 4 ) && ( roles[ 0 ] == S::PanelRole )
+        && ( roles[ 1 ] == S::GrooveRole ) && ( roles[ 2 ] == S::FillRole )
+        && ( roles[ 3 ] == S::HandleRole );
+}
+
 QskSliderSkinlet::QskSliderSkinlet( QskSkin* skin )
     : Inherited( skin )
+    , m_mergingBoxes( false )
 {
     setNodeRoles( { PanelRole, GrooveRole, FillRole, HandleRole } );
 }
@@ -38,6 +57,16 @@ QskSliderSkinlet::~QskSliderSkinlet()
 {
 }
 
+void QskSliderSkinlet::setMergingBoxes( bool on )
+{
+    m_mergingBoxes = on;
+}
+
+bool QskSliderSkinlet::isMergingBoxes() const
+{
+    return m_mergingBoxes;
+}
+
 QRectF QskSliderSkinlet::subControlRect( const QskSkinnable* skinnable,
     const QRectF& contentsRect, QskAspect::Subcontrol subControl ) const
 {
@@ -76,6 +105,17 @@ QSGNode* QskSliderSkinlet::updateSubNode(
 {
     const auto slider = static_cast< const QskSlider* >( skinnable );
 
+    if ( qskIsMergingBoxes( this ) )
+    {
+        if ( nodeRole == PanelRole )
+        {
+            return updateMergedBoxNode( slider, node,
+                { QskSlider::Panel, QskSlider::Groove, QskSlider::Fill, QskSlider::Handle } );
+        }
+
+        return nullptr;
+    }
+
     switch ( nodeRole )
     {
         case PanelRole:
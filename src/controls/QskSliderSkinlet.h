@@ -34,6 +34,15 @@ class QSK_EXPORT QskSliderSkinlet : public QskSkinlet
     QSizeF sizeHint( const QskSkinnable*,
         Qt::SizeHint, const QSizeF& ) const override;
 
+    /*
+        Drawing the boxes of panel, groove, fill and handle by one
+        geometry node with vertex colors. This reduces the number of
+        nodes, but the boxes can't be drawn with flat materials or
+        gradient textures anymore. The default setting is false.
+     */
+    void setMergingBoxes( bool );
+    bool isMergingBoxes() const;
+
   protected:
     QSGNode* updateSubNode( const QskSkinnable*,
         quint8 nodeRole, QSGNode* ) const override;
@@ -46,6 +55,8 @@ class QSK_EXPORT QskSliderSkinlet : public QskSkinlet
     QRectF scaleRect( const QskSlider*, const QRectF& ) const;
 
     QRectF innerRect( const QskSlider*, const QRectF&, QskAspect::Subcontrol ) const;
+
+    bool m_mergingBoxes;
 };
 
 #endif
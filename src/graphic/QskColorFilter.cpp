@@ -10,34 +10,17 @@
 #include <qpen.h>
 #include <qvariant.h>
 
-static inline QRgb qskSubstitutedRgb(
-    const QVector< QPair< QRgb, QRgb > >& substitions, QRgb rgba )
-{
-    // usually we have 2-3 substitutions, so we can simply iterate
-    // and don't need to introduce some sort of sorting or search index
-
-    const QRgb rgb = rgba | QskRgb::AlphaMask;
-
-    for ( const auto& s : substitions )
-    {
-        if ( rgb == s.first )
-        {
-            return ( s.second & QskRgb::ColorMask ) |
-                ( rgba & QskRgb::AlphaMask );
-        }
-    }
-
-    return rgba;
-}
+// usually we have 2-3 substitutions, where iterating is faster than a hash lookup
+static const int qskMaxLinearSubstitutions = 8;
 
 static inline QColor qskSubstitutedColor(
-    const QVector< QPair< QRgb, QRgb > >& substitions, const QColor& color )
+    const QskColorFilter& filter, const QColor& color )
 {
-    return QColor::fromRgba( qskSubstitutedRgb( substitions, color.rgba() ) );
+    return QColor::fromRgba( filter.substituted( color.rgba() ) );
 }
 
 static inline QBrush qskSubstitutedBrush(
-    const QVector< QPair< QRgb, QRgb > >& substitions, const QBrush& brush )
+    const QskColorFilter& filter, const QBrush& brush )
 {
     QBrush newBrush;
 
@@ -49,7 +32,7 @@ static inline QBrush qskSubstitutedBrush(
         QGradientStops stops = gradient->stops();
         for ( auto& stop : stops )
         {
-            const QColor c = qskSubstitutedColor( substitions, stop.second );
+            const QColor c = qskSubstitutedColor( filter, stop.second );
             if ( c != stop.second )
             {
                 stop.second = c;
@@ -67,7 +50,7 @@ static inline QBrush qskSubstitutedBrush(
     }
     else
     {
-        const QColor c = qskSubstitutedColor( substitions, brush.color() );
+        const QColor c = qskSubstitutedColor( filter, brush.color() );
         if ( c != brush.color() )
         {
             newBrush = brush;
@@ -150,16 +133,31 @@ void QskColorFilter::addColorSubstitution( QRgb from, QRgb to )
         if ( substitution.first == from )
         {
             substitution.second = to;
+
+            if ( !m_lookupTable.isEmpty() )
+                m_lookupTable.insert( from, to );
+
             return;
         }
     }
 
     m_substitutions += qMakePair( from, to );
+
+    if ( !m_lookupTable.isEmpty() )
+    {
+        m_lookupTable.insert( from, to );
+    }
+    else if ( m_substitutions.size() > qskMaxLinearSubstitutions )
+    {
+        for ( const auto& s : qskAsConst( m_substitutions ) )
+            m_lookupTable.insert( s.first, s.second );
+    }
 }
 
 void QskColorFilter::reset()
 {
     m_substitutions.clear();
+    m_lookupTable.clear();
 }
 
 QPen QskColorFilter::substituted( const QPen& pen ) const
@@ -167,7 +165,7 @@ QPen QskColorFilter::substituted( const QPen& pen ) const
     if ( m_substitutions.isEmpty() || pen.style() == Qt::NoPen )
         return pen;
 
-    const QBrush newBrush = qskSubstitutedBrush( m_substitutions, pen.brush() );
+    const QBrush newBrush = qskSubstitutedBrush( *this, pen.brush() );
     if ( newBrush.style() == Qt::NoBrush )
         return pen;
 
@@ -181,18 +179,47 @@ QBrush QskColorFilter::substituted( const QBrush& brush ) const
     if ( m_substitutions.isEmpty() || brush.style() == Qt::NoBrush )
         return brush;
 
-    const QBrush newBrush = qskSubstitutedBrush( m_substitutions, brush );
+    const QBrush newBrush = qskSubstitutedBrush( *this, brush );
     return ( newBrush.style() != Qt::NoBrush ) ? newBrush : brush;
 }
 
 QColor QskColorFilter::substituted( const QColor& color ) const
 {
-    return qskSubstitutedColor( m_substitutions, color );
+    return qskSubstitutedColor( *this, color );
+}
+
+QRgb QskColorFilter::substituted( const QRgb& rgba ) const
+{
+    const QRgb rgb = rgba | QskRgb::AlphaMask;
+
+    if ( !m_lookupTable.isEmpty() )
+    {
+        const auto it = m_lookupTable.constFind( rgb );
+        if ( it != m_lookupTable.constEnd() )
+            return ( it.value() & QskRgb::ColorMask ) | ( rgba & QskRgb::AlphaMask );
+
+        return rgba;
+    }
+
+    for ( const auto& s : m_substitutions )
+    {
+        if ( rgb == s.first )
+        {
+            return ( s.second & QskRgb::ColorMask ) |
+                ( rgba & QskRgb::AlphaMask );
+        }
+    }
+
+    return rgba;
 }
 
-QRgb QskColorFilter::substituted( const QRgb& rgb ) const
+uint QskColorFilter::hash( uint seed ) const noexcept
 {
-    return qskSubstitutedRgb( m_substitutions, rgb );
+    if ( m_substitutions.isEmpty() )
+        return seed;
+
+    return qHashBits( m_substitutions.constData(),
+        m_substitutions.size() * sizeof( m_substitutions[ 0 ] ), seed );
 }
 
 QskColorFilter QskColorFilter::interpolated(
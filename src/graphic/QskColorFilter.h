@@ -9,6 +9,7 @@
 #include "QskGlobal.h"
 
 #include <qcolor.h>
+#include <qhash.h>
 #include <qmetatype.h>
 #include <qpair.h>
 #include <qvector.h>
@@ -42,6 +43,8 @@ class QSK_EXPORT QskColorFilter
 
     const QVector< QPair< QRgb, QRgb > >& substitutions() const noexcept;
 
+    uint hash( uint seed ) const noexcept;
+
     QskColorFilter interpolated(
         const QskColorFilter&, qreal value ) const;
 
@@ -51,6 +54,9 @@ class QSK_EXPORT QskColorFilter
 
   private:
     QVector< QPair< QRgb, QRgb > > m_substitutions;
+
+    // an index for long lists of substitutions
+    QHash< QRgb, QRgb > m_lookupTable;
 };
 
 inline bool QskColorFilter::isIdentity() const noexcept
@@ -10,18 +10,108 @@
 
 #include <qguiapplication.h>
 #include <qimage.h>
+#include <qline.h>
 #include <qmath.h>
+#include <qmutex.h>
 #include <qpaintengine.h>
 #include <qpainter.h>
 #include <qpainterpath.h>
 #include <qpixmap.h>
 #include <qhashfunctions.h>
+#include <qcache.h>
+#include <qglobalstatic.h>
+#include <qbitarray.h>
+
+#include <memory>
 
 QSK_QT_PRIVATE_BEGIN
 #include <private/qpainter_p.h>
 #include <private/qpaintengineex_p.h>
 QSK_QT_PRIVATE_END
 
+static inline quint64 qskPathSize( const QPainterPath& path )
+{
+    return path.elementCount() * sizeof( QPainterPath::Element );
+}
+
+static inline quint64 qskImageSize( const QImage& image )
+{
+    return quint64( image.bytesPerLine() ) * image.height();
+}
+
+static inline quint64 qskPixmapSize( const QPixmap& pixmap )
+{
+    return quint64( pixmap.width() ) * pixmap.height() * pixmap.depth() / 8;
+}
+
+static inline quint64 qskBrushSize( const QBrush& brush )
+{
+    if ( brush.style() == Qt::TexturePattern )
+    {
+        const auto image = brush.textureImage();
+        return image.isNull() ? qskPixmapSize( brush.texture() ) : qskImageSize( image );
+    }
+
+    return 0;
+}
+
+// graphics with less paths are rendered without culling
+static const int qskMinCulledPaths = 100;
+
+/*
+    The visible part of the paint device in the coordinates of
+    the painter. We only cull for paint devices, where we know, that
+    the commands outside are invisible - not f.e. when recording
+    into another QskGraphic.
+ */
+static QRectF qskVisibleRect( const QPainter* painter )
+{
+    const auto engine = painter->paintEngine();
+    if ( engine == nullptr )
+        return QRectF();
+
+    switch ( static_cast< int >( engine->type() ) )
+    {
+        case QPaintEngine::Raster:
+        case QPaintEngine::OpenGL:
+        case QPaintEngine::OpenGL2:
+            break;
+
+        default:
+            return QRectF();
+    }
+
+    const auto device = painter->device();
+
+    bool isInvertible;
+    const auto transform = painter->deviceTransform().inverted( &isInvertible );
+
+    if ( device == nullptr || !isInvertible )
+        return QRectF();
+
+    /*
+        The bounding rectangles of the paths have been calculated for the
+        pens of the recording. As cosmetic pens do not scale we add
+        a couple of pixels.
+     */
+    const qreal margin = 8.0;
+
+    const QRectF deviceRect( -margin, -margin,
+        device->width() + 2 * margin, device->height() + 2 * margin );
+
+    auto rect = transform.mapRect( deviceRect );
+
+    if ( painter->hasClipping() )
+    {
+        const auto m = transform.mapRect( QRectF( 0.0, 0.0, margin, margin ) );
+
+        rect &= painter->clipBoundingRect().adjusted(
+            -m.width(), -m.height(), m.width(), m.height() );
+    }
+
+    return rect;
+}
+
 static inline qreal qskDevicePixelRatio()
 {
     return qGuiApp ? qGuiApp->devicePixelRatio() : 1.0;
@@ -250,81 +340,788 @@ namespace QskGraphicPrivate
                 const qreal t = qAbs( m_pointRect.top() - m_boundingRect.top() );
                 const qreal b = qAbs( m_pointRect.bottom() - m_boundingRect.bottom() );
 
-                rect.adjust( -l, -t, r, b );
-            }
+                rect.adjust( -l, -t, r, b );
+            }
+
+            return rect;
+        }
+
+        inline double scaleFactorX( const QRectF& pathRect,
+            const QRectF& targetRect, bool scalePens ) const
+        {
+            if ( pathRect.width() <= 0.0 )
+                return 0.0;
+
+            const QPointF p0 = m_pointRect.center();
+
+            const qreal l = qAbs( pathRect.left() - p0.x() );
+            const qreal r = qAbs( pathRect.right() - p0.x() );
+
+            const double w = 2.0 * qMin( l, r ) *
+                targetRect.width() / pathRect.width();
+
+            double sx;
+            if ( scalePens && m_scalablePen )
+            {
+                sx = w / m_boundingRect.width();
+            }
+            else
+            {
+                const qreal pw = qMax(
+                    qAbs( m_boundingRect.left() - m_pointRect.left() ),
+                    qAbs( m_boundingRect.right() - m_pointRect.right() ) );
+
+                sx = ( w - 2 * pw ) / m_pointRect.width();
+            }
+
+            return sx;
+        }
+
+        inline double scaleFactorY( const QRectF& pathRect,
+            const QRectF& targetRect, bool scalePens ) const
+        {
+            if ( pathRect.height() <= 0.0 )
+                return 0.0;
+
+            const QPointF p0 = m_pointRect.center();
+
+            const qreal t = qAbs( pathRect.top() - p0.y() );
+            const qreal b = qAbs( pathRect.bottom() - p0.y() );
+
+            const double h = 2.0 * qMin( t, b ) *
+                targetRect.height() / pathRect.height();
+
+            double sy;
+            if ( scalePens && m_scalablePen )
+            {
+                sy = h / m_boundingRect.height();
+            }
+            else
+            {
+                const double pw =
+                    qMax( qAbs( m_boundingRect.top() - m_pointRect.top() ),
+                        qAbs( m_boundingRect.bottom() - m_pointRect.bottom() ) );
+
+                sy = ( h - 2 * pw ) / m_pointRect.height();
+            }
+
+            return sy;
+        }
+
+        inline QRectF pointRect() const { return m_pointRect; }
+        inline QRectF boundingRect() const { return m_boundingRect; }
+        inline bool isScalablePen() const { return m_scalablePen; }
+
+      private:
+        QRectF m_pointRect;
+        QRectF m_boundingRect;
+        bool m_scalablePen;
+    };
+}
+
+namespace QskGraphicPrivate
+{
+    /*
+        A uniform grid over the bounding rectangle of a graphic, where
+        each cell knows the path commands intersecting it. The cells are
+        stored in one vector: the paths of cell i are
+        m_paths[ m_cellStart[ i ] ] ... m_paths[ m_cellStart[ i + 1 ] - 1 ].
+     */
+    class SpatialIndex
+    {
+      public:
+        SpatialIndex( quint64 id, const QRectF& boundingRect,
+                const QVector< QskPainterCommand >& commands,
+                const QVector< PathInfo >& pathInfos )
+            : modificationId( id )
+            , m_rect( boundingRect )
+            , m_commandCount( commands.size() )
+        {
+            const int pathCount = pathInfos.size();
+
+            const int dim = qBound( 1, qCeil( qSqrt( pathCount / 4.0 ) ), 64 );
+
+            m_columns = ( m_rect.width() > 0.0 ) ? dim : 1;
+            m_rows = ( m_rect.height() > 0.0 ) ? dim : 1;
+
+            QVector< int > pathCommands;
+            pathCommands.reserve( pathCount );
+
+            for ( int i = 0; i < commands.size(); i++ )
+            {
+                const auto& command = commands[ i ];
+
+                // there are no infos for empty paths
+                if ( command.type() == QskPainterCommand::Path && !command.path()->isEmpty() )
+                    pathCommands += i;
+            }
+
+            if ( pathCommands.size() != pathCount )
+            {
+                m_columns = m_rows = 0;
+                return;
+            }
+
+            const int cellCount = m_columns * m_rows;
+
+            // counting the entries of each cell, then filling them in
+
+            m_cellStart.fill( 0, cellCount + 1 );
+
+            for ( const auto& info : pathInfos )
+            {
+                const auto cells = cellRange( info.boundingRect() );
+
+                for ( int row = cells.top(); row <= cells.bottom(); row++ )
+                {
+                    for ( int col = cells.left(); col <= cells.right(); col++ )
+                        m_cellStart[ row * m_columns + col + 1 ]++;
+                }
+            }
+
+            for ( int i = 0; i < cellCount; i++ )
+                m_cellStart[ i + 1 ] += m_cellStart[ i ];
+
+            m_paths.resize( m_cellStart[ cellCount ] );
+
+            auto pos = m_cellStart;
+
+            for ( int i = 0; i < pathCount; i++ )
+            {
+                const auto cells = cellRange( pathInfos[ i ].boundingRect() );
+
+                for ( int row = cells.top(); row <= cells.bottom(); row++ )
+                {
+                    for ( int col = cells.left(); col <= cells.right(); col++ )
+                        m_paths[ pos[ row * m_columns + col ]++ ] = pathCommands[ i ];
+                }
+            }
+        }
+
+        inline bool isValid() const
+        {
+            return m_columns > 0;
+        }
+
+        // the commands of the paths, that might intersect with rect
+        QBitArray pathCommands( const QRectF& rect ) const
+        {
+            QBitArray commands( m_commandCount );
+
+            if ( !isValid() || !rect.intersects( m_rect ) )
+                return commands;
+
+            const auto cells = cellRange( rect );
+
+            for ( int row = cells.top(); row <= cells.bottom(); row++ )
+            {
+                for ( int col = cells.left(); col <= cells.right(); col++ )
+                {
+                    const int cell = row * m_columns + col;
+
+                    for ( int i = m_cellStart[ cell ]; i < m_cellStart[ cell + 1 ]; i++ )
+                        commands.setBit( m_paths[ i ] );
+                }
+            }
+
+            return commands;
+        }
+
+        const quint64 modificationId;
+
+      private:
+        QRect cellRange( const QRectF& rect ) const
+        {
+            const int left = cellIndex( rect.left(), m_rect.left(), m_rect.width(), m_columns );
+            const int right = cellIndex( rect.right(), m_rect.left(), m_rect.width(), m_columns );
+            const int top = cellIndex( rect.top(), m_rect.top(), m_rect.height(), m_rows );
+            const int bottom = cellIndex( rect.bottom(), m_rect.top(), m_rect.height(), m_rows );
+
+            return QRect( QPoint( left, top ), QPoint( right, bottom ) );
+        }
+
+        static inline int cellIndex( qreal value, qreal start, qreal length, int count )
+        {
+            if ( count <= 1 || length <= 0.0 )
+                return 0;
+
+            const int index = qFloor( ( value - start ) / length * count );
+            return qBound( 0, index, count - 1 );
+        }
+
+        const QRectF m_rect;
+        const int m_commandCount;
+
+        int m_columns = 0;
+        int m_rows = 0;
+
+        QVector< int > m_cellStart;
+        QVector< int > m_paths;
+    };
+}
+
+/*
+    Helpers for QskGraphic::optimize, that rewrites the commands
+    without changing the visual result.
+ */
+namespace QskGraphicPrivate
+{
+    static inline bool isVisiblePen( const QPen& pen )
+    {
+        return ( pen.style() != Qt::NoPen ) && ( pen.brush().style() != Qt::NoBrush );
+    }
+
+    static inline bool isTranslation( const QTransform& transform )
+    {
+        return transform.type() <= QTransform::TxTranslate;
+    }
+
+    static inline bool isPlainBrush( const QBrush& brush )
+    {
+        const auto style = brush.style();
+        return ( style == Qt::NoBrush ) || ( style == Qt::SolidPattern );
+    }
+
+    static inline qreal scaleFactor( const QTransform& transform )
+    {
+        const qreal det = qAbs( transform.determinant() );
+        return ( det > 0.0 ) ? qSqrt( det ) : 1.0;
+    }
+
+    // distance of p from the segment p1/p2, when its projection is inside
+    static inline bool isOnSegment( const QPointF& p,
+        const QPointF& p1, const QPointF& p2, qreal tolerance )
+    {
+        const qreal dx = p2.x() - p1.x();
+        const qreal dy = p2.y() - p1.y();
+
+        const qreal length2 = dx * dx + dy * dy;
+        if ( length2 <= 0.0 )
+            return QLineF( p1, p ).length() <= tolerance;
+
+        const qreal t = ( ( p.x() - p1.x() ) * dx + ( p.y() - p1.y() ) * dy ) / length2;
+        if ( t < 0.0 || t > 1.0 )
+            return false;
+
+        const qreal cross = ( p.x() - p1.x() ) * dy - ( p.y() - p1.y() ) * dx;
+        return qAbs( cross ) / qSqrt( length2 ) <= tolerance;
+    }
+
+    static void addPolyline( const QVector< QPointF >& points,
+        qreal tolerance, QPainterPath& path )
+    {
+        // the first point has already been added
+        const int count = points.size();
+
+        int anchor = 0;
+        int i = 1;
+
+        while ( i < count )
+        {
+            // extending the segment as long as all points in between are close to it
+            int end = i;
+
+            while ( end + 1 < count )
+            {
+                bool ok = true;
+
+                for ( int k = anchor + 1; k <= end; k++ )
+                {
+                    if ( !isOnSegment( points[ k ],
+                        points[ anchor ], points[ end + 1 ], tolerance ) )
+                    {
+                        ok = false;
+                        break;
+                    }
+                }
+
+                if ( !ok )
+                    break;
+
+                end++;
+            }
+
+            path.lineTo( points[ end ] );
+
+            anchor = end;
+            i = end + 1;
+        }
+    }
+
+    static QPainterPath simplifiedPath( const QPainterPath& path, qreal tolerance )
+    {
+        if ( tolerance <= 0.0 )
+            return path;
+
+        QPainterPath simplified;
+        simplified.setFillRule( path.fillRule() );
+
+        QVector< QPointF > polyline;
+
+        const auto flush = [ & ]()
+        {
+            if ( polyline.size() > 1 )
+                addPolyline( polyline, tolerance, simplified );
+
+            polyline.clear();
+        };
+
+        for ( int i = 0; i < path.elementCount(); i++ )
+        {
+            const auto element = path.elementAt( i );
+
+            switch ( element.type )
+            {
+                case QPainterPath::MoveToElement:
+                {
+                    flush();
+
+                    simplified.moveTo( element );
+                    polyline += element;
+
+                    break;
+                }
+                case QPainterPath::LineToElement:
+                {
+                    polyline += element;
+                    break;
+                }
+                case QPainterPath::CurveToElement:
+                {
+                    flush();
+
+                    const auto c1 = path.elementAt( i + 1 );
+                    const auto c2 = path.elementAt( i + 2 );
+
+                    simplified.cubicTo( element, c1, c2 );
+                    polyline += QPointF( c2 );
+
+                    i += 2;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        flush();
+
+        return ( simplified.elementCount() < path.elementCount() ) ? simplified : path;
+    }
+
+    class Optimizer
+    {
+      public:
+        Optimizer( qreal tolerance )
+            : m_tolerance( tolerance )
+        {
+        }
+
+        QVector< QskPainterCommand > optimized(
+            const QVector< QskPainterCommand >& commands )
+        {
+            for ( const auto& command : commands )
+            {
+                switch ( command.type() )
+                {
+                    case QskPainterCommand::Path:
+                    {
+                        addPath( *command.path() );
+                        break;
+                    }
+                    case QskPainterCommand::State:
+                    {
+                        addState( *command.stateData() );
+                        break;
+                    }
+                    default:
+                    {
+                        // pixmaps and images are drawn with the recorded transformation
+                        flushPath();
+                        flushTransform();
+
+                        m_commands += command;
+                    }
+                }
+            }
+
+            flushPath();
+
+            return m_commands;
+        }
+
+      private:
+        void addState( const QskPainterCommand::StateData& data )
+        {
+            using E = QPaintEngine;
+
+            auto state = data;
+
+            /*
+                Dropping what does not change the current state. Attributes
+                are unknown until being set, as the commands are rendered
+                on top of the state of the painter being passed to render().
+             */
+
+            if ( ( state.flags & E::DirtyPen ) && ( m_known & E::DirtyPen ) )
+            {
+                if ( state.pen == m_state.pen )
+                    state.flags &= ~E::DirtyPen;
+            }
+
+            if ( ( state.flags & E::DirtyBrush ) && ( m_known & E::DirtyBrush ) )
+            {
+                if ( state.brush == m_state.brush )
+                    state.flags &= ~E::DirtyBrush;
+            }
+
+            if ( ( state.flags & E::DirtyBrushOrigin ) && ( m_known & E::DirtyBrushOrigin ) )
+            {
+                if ( state.brushOrigin == m_state.brushOrigin )
+                    state.flags &= ~E::DirtyBrushOrigin;
+            }
+
+            if ( ( state.flags & E::DirtyFont ) && ( m_known & E::DirtyFont ) )
+            {
+                if ( state.font == m_state.font )
+                    state.flags &= ~E::DirtyFont;
+            }
+
+            if ( ( state.flags & E::DirtyBackground ) && ( m_known & E::DirtyBackground ) )
+            {
+                if ( state.backgroundMode == m_state.backgroundMode
+                    && state.backgroundBrush == m_state.backgroundBrush )
+                {
+                    state.flags &= ~E::DirtyBackground;
+                }
+            }
+
+            if ( ( state.flags & E::DirtyClipEnabled ) && ( m_known & E::DirtyClipEnabled ) )
+            {
+                if ( state.isClipEnabled == m_state.isClipEnabled )
+                    state.flags &= ~E::DirtyClipEnabled;
+            }
+
+            if ( ( state.flags & E::DirtyHints ) && ( m_known & E::DirtyHints ) )
+            {
+                if ( state.renderHints == m_state.renderHints )
+                    state.flags &= ~E::DirtyHints;
+            }
+
+            if ( ( state.flags & E::DirtyCompositionMode )
+                && ( m_known & E::DirtyCompositionMode ) )
+            {
+                if ( state.compositionMode == m_state.compositionMode )
+                    state.flags &= ~E::DirtyCompositionMode;
+            }
+
+            if ( ( state.flags & E::DirtyOpacity ) && ( m_known & E::DirtyOpacity ) )
+            {
+                if ( qFuzzyCompare( state.opacity, m_state.opacity ) )
+                    state.flags &= ~E::DirtyOpacity;
+            }
+
+            if ( state.flags & E::DirtyTransform )
+            {
+                // the transformation is delayed until being needed
+                m_transform = state.transform;
+                state.flags &= ~E::DirtyTransform;
+            }
+
+            const auto clipFlags = E::DirtyClipRegion | E::DirtyClipPath;
+
+            if ( state.flags & clipFlags )
+            {
+                // clip regions/paths are mapped, when being set
+                if ( m_emittedTransform != m_transform )
+                {
+                    state.flags |= E::DirtyTransform;
+                    state.transform = m_transform;
+                }
+            }
+
+            if ( !state.flags )
+                return;
+
+            flushPath();
+
+            if ( state.flags & E::DirtyTransform )
+                m_emittedTransform = state.transform;
+
+            m_state = mergedState( m_state, state );
+            m_known |= state.flags;
+
+            m_commands += QskPainterCommand( state );
+        }
+
+        void addPath( const QPainterPath& path )
+        {
+            /*
+                When the result does not depend on the transformation
+                we can map the coordinates and avoid the state changes.
+             */
+            const bool doMap = isMappable();
+
+            QPainterPath p = path;
+
+            if ( doMap )
+            {
+                p = m_transform.map( path );
+                setEmittedTransform( QTransform() );
+            }
+            else
+            {
+                setEmittedTransform( m_transform );
+            }
+
+            if ( !m_pendingPath.isEmpty() )
+            {
+                if ( ( doMap == m_isPendingMapped ) && isMergeable( p ) )
+                {
+                    m_pendingPath.addPath( p );
+                    return;
+                }
+
+                flushPath();
+            }
+
+            m_pendingPath = p;
+            m_isPendingMapped = doMap;
+        }
+
+        bool isMappable() const
+        {
+            using E = QPaintEngine;
+
+            if ( m_transform.isIdentity() )
+                return true;
+
+            if ( ( m_known & ( E::DirtyPen | E::DirtyBrush ) )
+                != ( E::DirtyPen | E::DirtyBrush ) )
+            {
+                return false;
+            }
+
+            const auto& pen = m_state.pen;
+            if ( isVisiblePen( pen ) && !pen.isCosmetic() && !isTranslation( m_transform ) )
+                return false;
+
+            // gradients and textures are aligned to the coordinate system
+            return isPlainBrush( m_state.brush ) && isPlainBrush( pen.brush() );
+        }
+
+        bool isMergeable( const QPainterPath& path ) const
+        {
+            using E = QPaintEngine;
+
+            if ( path.fillRule() != m_pendingPath.fillRule() )
+                return false;
+
+            if ( !( m_known & E::DirtyPen ) )
+                return false;
+
+            /*
+                Overlapping parts would change the result: f.e. because of
+                the fill rule or when being painted with alpha twice.
+             */
+            qreal margin = 0.0;
+
+            const auto& pen = m_state.pen;
+            if ( isVisiblePen( pen ) )
+            {
+                if ( pen.isCosmetic() && !m_isPendingMapped )
+                    return false;
+
+                margin = qMax( pen.widthF(), qreal( 1.0 ) )
+                    * qMax( pen.miterLimit(), qreal( 1.0 ) );
+            }
+
+            // antialiasing might leak out by one pixel
+            margin += 1.0;
+
+            const auto r1 = path.controlPointRect().adjusted(
+                -margin, -margin, margin, margin );
+
+            const auto r2 = m_pendingPath.controlPointRect().adjusted(
+                -margin, -margin, margin, margin );
+
+            return !r1.intersects( r2 );
+        }
+
+        void setEmittedTransform( const QTransform& transform )
+        {
+            if ( transform == m_emittedTransform )
+                return;
+
+            flushPath();
+
+            QskPainterCommand::StateData state;
+            state.flags = QPaintEngine::DirtyTransform;
+            state.transform = transform;
+
+            m_commands += QskPainterCommand( state );
+            m_emittedTransform = transform;
+        }
+
+        void flushTransform()
+        {
+            setEmittedTransform( m_transform );
+        }
+
+        void flushPath()
+        {
+            if ( m_pendingPath.isEmpty() )
+                return;
+
+            qreal tolerance = m_tolerance;
+            if ( !m_isPendingMapped )
+                tolerance /= scaleFactor( m_emittedTransform );
+
+            m_commands += QskPainterCommand(
+                simplifiedPath( m_pendingPath, tolerance ) );
 
-            return rect;
+            m_pendingPath = QPainterPath();
         }
 
-        inline double scaleFactorX( const QRectF& pathRect,
-            const QRectF& targetRect, bool scalePens ) const
+        static QskPainterCommand::StateData mergedState(
+            const QskPainterCommand::StateData& state,
+            const QskPainterCommand::StateData& changes )
         {
-            if ( pathRect.width() <= 0.0 )
-                return 0.0;
+            using E = QPaintEngine;
 
-            const QPointF p0 = m_pointRect.center();
+            auto s = state;
 
-            const qreal l = qAbs( pathRect.left() - p0.x() );
-            const qreal r = qAbs( pathRect.right() - p0.x() );
+            if ( changes.flags & E::DirtyPen )
+                s.pen = changes.pen;
 
-            const double w = 2.0 * qMin( l, r ) *
-                targetRect.width() / pathRect.width();
+            if ( changes.flags & E::DirtyBrush )
+                s.brush = changes.brush;
 
-            double sx;
-            if ( scalePens && m_scalablePen )
+            if ( changes.flags & E::DirtyBrushOrigin )
+                s.brushOrigin = changes.brushOrigin;
+
+            if ( changes.flags & E::DirtyFont )
+                s.font = changes.font;
+
+            if ( changes.flags & E::DirtyBackground )
             {
-                sx = w / m_boundingRect.width();
+                s.backgroundMode = changes.backgroundMode;
+                s.backgroundBrush = changes.backgroundBrush;
             }
-            else
-            {
-                const qreal pw = qMax(
-                    qAbs( m_boundingRect.left() - m_pointRect.left() ),
-                    qAbs( m_boundingRect.right() - m_pointRect.right() ) );
 
-                sx = ( w - 2 * pw ) / m_pointRect.width();
-            }
+            if ( changes.flags & E::DirtyClipEnabled )
+                s.isClipEnabled = changes.isClipEnabled;
 
-            return sx;
+            if ( changes.flags & E::DirtyHints )
+                s.renderHints = changes.renderHints;
+
+            if ( changes.flags & E::DirtyCompositionMode )
+                s.compositionMode = changes.compositionMode;
+
+            if ( changes.flags & E::DirtyOpacity )
+                s.opacity = changes.opacity;
+
+            return s;
         }
 
-        inline double scaleFactorY( const QRectF& pathRect,
-            const QRectF& targetRect, bool scalePens ) const
+        const qreal m_tolerance;
+
+        QskPainterCommand::StateData m_state;
+        QPaintEngine::DirtyFlags m_known;
+
+        // the recorded transformation and the one of the optimized commands
+        QTransform m_transform;
+        QTransform m_emittedTransform;
+
+        QPainterPath m_pendingPath;
+        bool m_isPendingMapped = false;
+
+        QVector< QskPainterCommand > m_commands;
+    };
+}
+
+static bool qskIsFiltered( const QVector< QskPainterCommand >& commands,
+    const QskColorFilter& colorFilter )
+{
+    for ( const auto& command : commands )
+    {
+        if ( command.type() != QskPainterCommand::State )
+            continue;
+
+        const auto data = command.stateData();
+
+        if ( data->flags & QPaintEngine::DirtyPen )
         {
-            if ( pathRect.height() <= 0.0 )
-                return 0.0;
+            if ( colorFilter.substituted( data->pen ) != data->pen )
+                return true;
+        }
 
-            const QPointF p0 = m_pointRect.center();
+        if ( data->flags & QPaintEngine::DirtyBrush )
+        {
+            if ( colorFilter.substituted( data->brush ) != data->brush )
+                return true;
+        }
 
-            const qreal t = qAbs( pathRect.top() - p0.y() );
-            const qreal b = qAbs( pathRect.bottom() - p0.y() );
+        if ( data->flags & QPaintEngine::DirtyBackground )
+        {
+            if ( colorFilter.substituted( data->backgroundBrush ) != data->backgroundBrush )
+                return true;
+        }
+    }
 
-            const double h = 2.0 * qMin( t, b ) *
-                targetRect.height() / pathRect.height();
+    return false;
+}
 
-            double sy;
-            if ( scalePens && m_scalablePen )
-            {
-                sy = h / m_boundingRect.height();
-            }
-            else
-            {
-                const double pw =
-                    qMax( qAbs( m_boundingRect.top() - m_pointRect.top() ),
-                        qAbs( m_boundingRect.bottom() - m_pointRect.bottom() ) );
+static inline quint64 qskNextModificationId()
+{
+    static QAtomicInteger< quint64 > nextId( 1 );
+    return nextId.fetchAndAddRelaxed( 1 );
+}
 
-                sy = ( h - 2 * pw ) / m_pointRect.height();
-            }
+namespace
+{
+    /*
+        Filtered graphics are usually requested for the same icons
+        again and again - f.e. when being rasterized for different sizes.
+        The substitutions are part of the key, so that different
+        filters can't be mixed up because of a hash collision.
+
+        For filters, that don't substitute any color of a graphic,
+        a null graphic is cached.
+     */
+    class FilterKey
+    {
+      public:
+        inline bool operator==( const FilterKey& other ) const
+        {
+            return ( modificationId == other.modificationId )
+                && ( filter == other.filter );
+        }
 
-            return sy;
+        quint64 modificationId;
+        QskColorFilter filter;
+    };
+
+    inline uint qHash( const FilterKey& key, uint seed = 0 )
+    {
+        return key.filter.hash( qHash( key.modificationId, seed ) );
+    }
+
+    class FilterCache
+    {
+      public:
+        FilterCache()
+            : cache( 4 * 1024 * 1024 )
+        {
         }
 
-      private:
-        QRectF m_pointRect;
-        QRectF m_boundingRect;
-        bool m_scalablePen;
+        QMutex mutex;
+        QCache< FilterKey, QskGraphic > cache; // cost: bytes
     };
 }
 
+Q_GLOBAL_STATIC( FilterCache, qskFilterCache )
+
 class QskGraphic::PrivateData : public QSharedData
 {
   public:
@@ -336,15 +1133,34 @@ class QskGraphic::PrivateData : public QSharedData
 
     PrivateData( const PrivateData& other )
         : QSharedData( other )
-        , defaultSize( other.defaultSize )
-        , commands( other.commands )
-        , pathInfos( other.pathInfos )
-        , boundingRect( other.boundingRect )
-        , pointRect( other.pointRect )
-        , modificationId( other.modificationId )
-        , commandTypes( other.commandTypes )
-        , renderHints( other.renderHints )
+        , commandTypes( 0 )
+        , renderHints( 0 )
     {
+        {
+            /*
+                Instead of decoding the commands of a lazy graphic,
+                what might never be needed, the copy takes the loader.
+             */
+            QMutexLocker locker( &other.mutex );
+
+            if ( other.isPending.loadAcquire() != 0 )
+            {
+                loader = other.loader;
+                isPending.storeRelease( 1 );
+            }
+            else
+            {
+                commands = other.commands;
+                pathInfos = other.pathInfos;
+            }
+        }
+
+        defaultSize = other.defaultSize;
+        boundingRect = other.boundingRect;
+        pointRect = other.pointRect;
+        modificationId = other.modificationId;
+        commandTypes = other.commandTypes;
+        renderHints = other.renderHints;
     }
 
     inline bool operator==( const PrivateData& other ) const
@@ -356,10 +1172,60 @@ class QskGraphic::PrivateData : public QSharedData
 
     inline void addCommand( const QskPainterCommand& command )
     {
+        load();
+
         commands += command;
+        modificationId = qskNextModificationId();
+    }
+
+    inline void load() const
+    {
+        if ( isPending.loadAcquire() == 0 )
+            return;
+
+        QMutexLocker locker( &mutex );
+
+        // another thread might have been faster
+        if ( isPending.loadAcquire() == 0 )
+            return;
+
+        /*
+            The decoded commands are the same for all copies sharing
+            this data, so we can modify it even for const graphics.
+         */
+        auto that = const_cast< PrivateData* >( this );
+
+        const auto graphic = loader();
+        if ( graphic.isNull() )
+            qWarning( "QskGraphic: decoding the commands failed" );
+
+        that->commands = graphic.m_data->commands;
+        that->pathInfos = graphic.m_data->pathInfos;
+        that->loader = nullptr;
+
+        that->isPending.storeRelease( 0 );
+    }
+
+    std::shared_ptr< const QskGraphicPrivate::SpatialIndex > spatialIndex() const
+    {
+        // usually the index exists already: no need to lock
+        auto spatialIndex = std::atomic_load( &index );
+        if ( spatialIndex && spatialIndex->modificationId == modificationId )
+            return spatialIndex;
+
+        // avoiding, that several threads create the index at the same time
+        QMutexLocker locker( &mutex );
+
+        spatialIndex = std::atomic_load( &index );
+        if ( spatialIndex == nullptr || spatialIndex->modificationId != modificationId )
+        {
+            spatialIndex = std::make_shared< const QskGraphicPrivate::SpatialIndex >(
+                modificationId, boundingRect, commands, pathInfos );
+
+            std::atomic_store( &index, spatialIndex );
+        }
 
-        static QAtomicInteger< quint64 > nextId( 1 );
-        modificationId = nextId.fetchAndAddRelaxed( 1 );
+        return spatialIndex;
     }
 
     QSizeF defaultSize;
@@ -371,6 +1237,16 @@ class QskGraphic::PrivateData : public QSharedData
 
     quint64 modificationId = 0;
 
+    // decoding the commands of lazy graphics
+    std::function< QskGraphic() > loader;
+    QAtomicInt isPending;
+
+    // for decoding and creating the spatial index
+    mutable QMutex mutex;
+
+    // culling the paths of large graphics, created when rendering
+    mutable std::shared_ptr< const QskGraphicPrivate::SpatialIndex > index;
+
     uint commandTypes : 4;
     uint renderHints : 4;
 };
@@ -480,16 +1356,14 @@ int QskGraphic::metric( PaintDeviceMetric deviceMetric ) const
 
 void QskGraphic::reset()
 {
-    m_data->commands.clear();
-    m_data->pathInfos.clear();
-
-    m_data->commandTypes = 0;
+    /*
+        Starting with new data instead of detaching, what would
+        copy - or even decode - the commands only to throw them away.
+     */
+    const auto renderHints = m_data.constData()->renderHints;
 
-    m_data->boundingRect = QRectF( 0.0, 0.0, -1.0, -1.0 );
-    m_data->pointRect = QRectF( 0.0, 0.0, -1.0, -1.0 );
-    m_data->defaultSize = QSizeF();
-
-    m_data->modificationId = 0;
+    m_data = new PrivateData();
+    m_data->renderHints = renderHints;
 
     delete m_paintEngine;
     m_paintEngine = nullptr;
@@ -497,9 +1371,17 @@ void QskGraphic::reset()
 
 bool QskGraphic::isNull() const
 {
+    if ( isLazy() )
+        return false;
+
     return m_data->commands.isEmpty();
 }
 
+bool QskGraphic::isLazy() const
+{
+    return m_data->isPending.loadAcquire() != 0;
+}
+
 bool QskGraphic::isEmpty() const
 {
     return m_data->boundingRect.isEmpty();
@@ -549,6 +1431,8 @@ QRectF QskGraphic::scaledBoundingRect( qreal sx, qreal sy ) const
     if ( sx == 1.0 && sy == 1.0 )
         return m_data->boundingRect;
 
+    m_data->load();
+
     const bool scalePens = !( m_data->renderHints & RenderPensUnscaled );
 
     QTransform transform;
@@ -613,17 +1497,46 @@ void QskGraphic::render( QPainter* painter,
     if ( isNull() )
         return;
 
+    m_data->load();
+
     const int numCommands = m_data->commands.size();
     const auto commands = m_data->commands.constData();
 
     const auto transform = painter->transform();
     const QskGraphic::RenderHints renderHints( m_data->renderHints );
 
+    /*
+        When only a part of a large graphic is visible - f.e. a zoomed
+        in map - we skip the paths outside of it.
+     */
+    QBitArray visiblePaths;
+
+    if ( !( renderHints & RenderPensUnscaled )
+        && m_data->pathInfos.size() >= qskMinCulledPaths )
+    {
+        const auto visibleRect = qskVisibleRect( painter );
+
+        if ( !visibleRect.isNull() && !visibleRect.contains( m_data->boundingRect ) )
+        {
+            const auto index = m_data->spatialIndex();
+            if ( index->isValid() )
+                visiblePaths = index->pathCommands( visibleRect );
+        }
+    }
+
     painter->save();
 
     for ( int i = 0; i < numCommands; i++ )
     {
-        qskExecCommand( painter, commands[ i ], colorFilter,
+        const auto& command = commands[ i ];
+
+        if ( !visiblePaths.isEmpty() && command.type() == QskPainterCommand::Path )
+        {
+            if ( !visiblePaths.testBit( i ) )
+                continue;
+        }
+
+        qskExecCommand( painter, command, colorFilter,
             renderHints, transform, initialTransform );
     }
 
@@ -649,6 +1562,8 @@ void QskGraphic::render( QPainter* painter, const QRectF& rect,
     if ( isEmpty() || rect.isEmpty() )
         return;
 
+    m_data->load();
+
     qreal sx = 1.0;
     qreal sy = 1.0;
 
@@ -954,6 +1869,7 @@ void QskGraphic::updateControlPointRect( const QRectF& rect )
 
 const QVector< QskPainterCommand >& QskGraphic::commands() const
 {
+    m_data->load();
     return m_data->commands;
 }
 
@@ -984,11 +1900,224 @@ void QskGraphic::setCommands( const QVector< QskPainterCommand >& commands )
     painter.end();
 }
 
+void QskGraphic::setCommands( const QVector< QskPainterCommand >& commands,
+    const QVector< PathMetrics >& pathMetrics, const QRectF& boundingRect,
+    const QRectF& controlPointRect, CommandTypes commandTypes )
+{
+    reset();
+
+    if ( commands.isEmpty() )
+        return;
+
+    m_data->commands = commands;
+
+    m_data->pathInfos.reserve( pathMetrics.size() );
+    for ( const auto& metrics : pathMetrics )
+    {
+        m_data->pathInfos += QskGraphicPrivate::PathInfo(
+            metrics.pointRect, metrics.boundingRect, metrics.scalablePen );
+    }
+
+    m_data->boundingRect = boundingRect;
+    m_data->pointRect = controlPointRect;
+    m_data->commandTypes = commandTypes;
+
+    m_data->modificationId = qskNextModificationId();
+}
+
+QVector< QskGraphic::PathMetrics > QskGraphic::pathMetrics() const
+{
+    m_data->load();
+
+    QVector< PathMetrics > pathMetrics;
+    pathMetrics.reserve( m_data->pathInfos.size() );
+
+    for ( const auto& info : qskAsConst( m_data->pathInfos ) )
+    {
+        pathMetrics += PathMetrics {
+            info.pointRect(), info.boundingRect(), info.isScalablePen() };
+    }
+
+    return pathMetrics;
+}
+
+void QskGraphic::optimize( qreal tolerance )
+{
+    if ( isNull() )
+        return;
+
+    QskGraphicPrivate::Optimizer optimizer( tolerance );
+    const auto optimizedCommands = optimizer.optimized( commands() );
+
+    const auto defaultSize = m_data->defaultSize;
+
+    setCommands( optimizedCommands );
+    m_data->defaultSize = defaultSize;
+}
+
+QskGraphic QskGraphic::filtered( const QskColorFilter& colorFilter ) const
+{
+    if ( colorFilter.isIdentity() || isNull() )
+        return *this;
+
+    const FilterKey key { m_data->modificationId, colorFilter };
+
+    QskGraphic graphic;
+
+    {
+        QMutexLocker locker( &qskFilterCache->mutex );
+
+        if ( auto cached = qskFilterCache->cache.object( key ) )
+        {
+            // a null graphic: the filter does not substitute anything
+            if ( cached->isNull() )
+                return *this;
+
+            graphic = *cached;
+        }
+    }
+
+    if ( graphic.isNull() )
+    {
+        const bool isModified = qskIsFiltered( commands(), colorFilter );
+
+        if ( isModified )
+        {
+            graphic = *this; // detaching below decodes lazy graphics
+
+            for ( auto& command : graphic.m_data->commands )
+            {
+                if ( command.type() != QskPainterCommand::State )
+                    continue;
+
+                auto data = command.stateData();
+
+                if ( data->flags & QPaintEngine::DirtyPen )
+                    data->pen = colorFilter.substituted( data->pen );
+
+                if ( data->flags & QPaintEngine::DirtyBrush )
+                    data->brush = colorFilter.substituted( data->brush );
+
+                if ( data->flags & QPaintEngine::DirtyBackground )
+                    data->backgroundBrush = colorFilter.substituted( data->backgroundBrush );
+            }
+
+            graphic.m_data->modificationId = qskNextModificationId();
+        }
+
+        QMutexLocker locker( &qskFilterCache->mutex );
+
+        auto& cache = qskFilterCache->cache;
+
+        const auto cost = qBound( quint64( 1 ),
+            graphic.sizeInBytes(), quint64( cache.maxCost() ) );
+
+        cache.insert( key, new QskGraphic( graphic ), static_cast< int >( cost ) );
+
+        if ( !isModified )
+            return *this;
+    }
+
+    // copies sharing the commands might differ in these attributes
+    const auto d = graphic.m_data.constData();
+
+    if ( d->defaultSize != m_data->defaultSize )
+        graphic.m_data->defaultSize = m_data->defaultSize;
+
+    if ( d->renderHints != m_data->renderHints )
+        graphic.m_data->renderHints = m_data->renderHints;
+
+    return graphic;
+}
+
+void QskGraphic::setLazyCommands( const std::function< QskGraphic() >& loader,
+    const QRectF& boundingRect, const QRectF& controlPointRect,
+    CommandTypes commandTypes )
+{
+    reset();
+
+    if ( !loader )
+        return;
+
+    m_data->loader = loader;
+    m_data->isPending.storeRelease( 1 );
+
+    m_data->boundingRect = boundingRect;
+    m_data->pointRect = controlPointRect;
+    m_data->commandTypes = commandTypes;
+
+    m_data->modificationId = qskNextModificationId();
+}
+
 quint64 QskGraphic::modificationId() const
 {
     return m_data->modificationId;
 }
 
+quint64 QskGraphic::sizeInBytes() const
+{
+    quint64 size = sizeof( QskGraphic ) + sizeof( PrivateData );
+
+    /*
+        The commands of lazy graphics are not decoded here: as long
+        as they are pending only the allocated memory is counted.
+     */
+    if ( isLazy() )
+        return size;
+
+    size += m_data->pathInfos.capacity() * sizeof( QskGraphicPrivate::PathInfo );
+    size += m_data->commands.capacity() * sizeof( QskPainterCommand );
+
+    for ( const auto& command : qskAsConst( m_data->commands ) )
+    {
+        switch ( command.type() )
+        {
+            case QskPainterCommand::Path:
+            {
+                size += qskPathSize( *command.path() );
+                break;
+            }
+            case QskPainterCommand::Pixmap:
+            {
+                const auto data = command.pixmapData();
+
+                size += sizeof( *data );
+                size += qskPixmapSize( data->pixmap );
+
+                break;
+            }
+            case QskPainterCommand::Image:
+            {
+                const auto data = command.imageData();
+
+                size += sizeof( *data );
+                size += qskImageSize( data->image );
+
+                break;
+            }
+            case QskPainterCommand::State:
+            {
+                const auto data = command.stateData();
+
+                size += sizeof( *data );
+
+                size += qskBrushSize( data->pen.brush() );
+                size += qskBrushSize( data->brush );
+                size += qskBrushSize( data->backgroundBrush );
+
+                size += qskPathSize( data->clipPath );
+                size += data->clipRegion.rectCount() * sizeof( QRect );
+
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    return size;
+}
+
 uint QskGraphic::hash( uint seed ) const
 {
     auto hash = qHash( m_data->renderHints, seed );
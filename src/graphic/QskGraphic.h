@@ -11,8 +11,11 @@
 #include <qmetatype.h>
 #include <qflags.h>
 #include <qpaintdevice.h>
+#include <qrect.h>
 #include <qshareddata.h>
 
+#include <functional>
+
 class QskPainterCommand;
 class QskColorFilter;
 class QskGraphicPaintEngine;
@@ -43,6 +46,20 @@ class QSK_EXPORT QskGraphic : public QPaintDevice
 
     typedef QFlags< CommandType > CommandTypes;
 
+    /*
+        Geometry of a path command, that is calculated when recording
+        the commands. It can be stored together with the commands
+        ( see QskGraphicIO ), so that restoring a graphic does not
+        need to replay the commands.
+     */
+    class PathMetrics
+    {
+      public:
+        QRectF pointRect;
+        QRectF boundingRect;
+        bool scalablePen;
+    };
+
     QskGraphic();
     QskGraphic( const QskGraphic& );
     QskGraphic( QskGraphic&& );
@@ -98,6 +115,41 @@ class QSK_EXPORT QskGraphic : public QPaintDevice
     const QVector< QskPainterCommand >& commands() const;
     void setCommands( const QVector< QskPainterCommand >& );
 
+    // restoring precalculated metrics instead of replaying the commands
+    void setCommands( const QVector< QskPainterCommand >&,
+        const QVector< PathMetrics >&, const QRectF& boundingRect,
+        const QRectF& controlPointRect, CommandTypes );
+
+    QVector< PathMetrics > pathMetrics() const;
+
+    /*
+        A graphic, where only the metrics are known in advance. The commands
+        are decoded by the loader, when being needed for the first time -
+        usually when rendering. ( see QskGraphicIO::readLazy )
+     */
+    void setLazyCommands( const std::function< QskGraphic() >& loader,
+        const QRectF& boundingRect, const QRectF& controlPointRect, CommandTypes );
+
+    bool isLazy() const;
+
+    /*
+        Rewriting the commands without changing the result: redundant
+        state changes are dropped, transformations are applied to the
+        coordinates of paths, when possible, and consecutive paths
+        with the same attributes are merged, when not overlapping.
+
+        Points of lines, that are closer than tolerance to the line
+        between their neighbours, are removed.
+     */
+    void optimize( qreal tolerance = 0.0 );
+
+    /*
+        A graphic with the substitutions of the filter being applied
+        to its pens and brushes, so that rendering it without a filter
+        gives the same result. Filtered graphics are cached.
+     */
+    QskGraphic filtered( const QskColorFilter& ) const;
+
     void setDefaultSize( const QSizeF& );
     QSizeF defaultSize() const;
 
@@ -118,6 +170,12 @@ class QSK_EXPORT QskGraphic : public QPaintDevice
     quint64 modificationId() const;
     uint hash( uint seed ) const;
 
+    /*
+        An estimate of the memory, that is allocated for the graphic.
+        Lazy graphics, that have not been decoded, are small.
+     */
+    quint64 sizeInBytes() const;
+
   protected:
     friend class QskGraphicPaintEngine;
 
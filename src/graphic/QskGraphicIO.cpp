@@ -15,6 +15,96 @@
 #include <cstring>
 
 static const char qskMagicNumber[] = "QSKG";
+static const char qskMappedMagicNumber[] = "QSKM";
+
+namespace
+{
+    /*
+        Layout of the mapped format:
+
+            MappedHeader
+            MappedCommand[ commandCount ]
+            MappedPathMetrics[ pathCount ]
+            MappedElement[ elementCount ]
+            QDataStream data for states, pixmaps and images[ dataSize ]
+
+        All records have a size, that is a multiple of 8, so that
+        the doubles are aligned, when the file is mapped to a page.
+     */
+
+    enum
+    {
+        MappedVersion = 2,
+        ByteOrderMark = 0x0102
+    };
+
+    struct MappedHeader
+    {
+        char magicNumber[ 4 ];
+        quint16 version;
+        quint16 byteOrder;
+
+        quint32 commandCount;
+        quint32 pathCount;
+        quint32 elementCount;
+        quint32 dataSize;
+
+        quint32 commandTypes;
+        quint32 reserved;
+
+        double boundingRect[ 4 ];
+        double pointRect[ 4 ];
+    };
+
+    struct MappedCommand
+    {
+        quint8 type;
+        quint8 fillRule;
+        quint16 reserved1;
+
+        // elements of a path, or bytes in the data section
+        quint32 offset;
+        quint32 count;
+
+        quint32 reserved2;
+    };
+
+    struct MappedPathMetrics
+    {
+        double pointRect[ 4 ];
+        double boundingRect[ 4 ];
+
+        quint32 scalablePen;
+        quint32 reserved;
+    };
+
+    struct MappedElement
+    {
+        double x;
+        double y;
+
+        qint32 type;
+        qint32 reserved;
+    };
+
+    static_assert( sizeof( MappedHeader ) == 96, "Bad MappedHeader" );
+    static_assert( sizeof( MappedCommand ) == 16, "Bad MappedCommand" );
+    static_assert( sizeof( MappedPathMetrics ) == 72, "Bad MappedPathMetrics" );
+    static_assert( sizeof( MappedElement ) == 24, "Bad MappedElement" );
+}
+
+static inline void qskStoreRect( const QRectF& rect, double values[ 4 ] )
+{
+    values[ 0 ] = rect.x();
+    values[ 1 ] = rect.y();
+    values[ 2 ] = rect.width();
+    values[ 3 ] = rect.height();
+}
+
+static inline QRectF qskRestoreRect( const double values[ 4 ] )
+{
+    return QRectF( values[ 0 ], values[ 1 ], values[ 2 ], values[ 3 ] );
+}
 
 static inline void qskWritePathData(
     const QPainterPath& path, QDataStream& s )
@@ -195,31 +285,209 @@ static inline void qskReadStateData(
     commands += QskPainterCommand( data );
 }
 
-QskGraphic QskGraphicIO::read( const QString& fileName )
+static bool qskReadMappedPath( const MappedCommand& command,
+    const MappedElement* elements, QVector< QskPainterCommand >& commands )
 {
-    QFile file( fileName );
-    if ( file.open( QIODevice::ReadOnly ) == false )
+    QPainterPath path;
+    path.setFillRule( static_cast< Qt::FillRule >( command.fillRule ) );
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 13, 0 )
+    path.reserve( command.count );
+#endif
+
+    const auto e = elements + command.offset;
+
+    for ( uint i = 0; i < command.count; i++ )
     {
-        qWarning( "QskGraphicIO::read can't open %s", qPrintable( fileName ) );
+        switch ( e[ i ].type )
+        {
+            case QPainterPath::MoveToElement:
+            {
+                path.moveTo( e[ i ].x, e[ i ].y );
+                break;
+            }
+            case QPainterPath::LineToElement:
+            {
+                path.lineTo( e[ i ].x, e[ i ].y );
+                break;
+            }
+            case QPainterPath::CurveToElement:
+            {
+                if ( i + 2 >= command.count )
+                    return false;
+
+                path.cubicTo( e[ i ].x, e[ i ].y,
+                    e[ i + 1 ].x, e[ i + 1 ].y, e[ i + 2 ].x, e[ i + 2 ].y );
+
+                i += 2;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    commands += QskPainterCommand( path );
+    return true;
+}
+
+static QskGraphic qskReadMapped( const char* data, qint64 size )
+{
+    if ( reinterpret_cast< quintptr >( data ) % alignof( double ) )
+    {
+        // QByteArray::fromRawData might be anywhere
+        const QByteArray alignedData( data, size );
+        return qskReadMapped( alignedData.constData(), size );
+    }
+
+    if ( size < qint64( sizeof( MappedHeader ) ) )
+        return QskGraphic();
+
+    const auto header = reinterpret_cast< const MappedHeader* >( data );
+
+    if ( header->version != MappedVersion || header->byteOrder != ByteOrderMark )
+    {
+        qWarning( "QskGraphicIO::read: incompatible version or byte order" );
         return QskGraphic();
     }
 
-    return read( &file );
+    const qint64 commandsOffset = sizeof( MappedHeader );
+    const qint64 metricsOffset = commandsOffset
+        + qint64( header->commandCount ) * sizeof( MappedCommand );
+    const qint64 elementsOffset = metricsOffset
+        + qint64( header->pathCount ) * sizeof( MappedPathMetrics );
+    const qint64 dataOffset = elementsOffset
+        + qint64( header->elementCount ) * sizeof( MappedElement );
+
+    if ( dataOffset + header->dataSize > size )
+    {
+        qWarning( "QskGraphicIO::read: truncated data" );
+        return QskGraphic();
+    }
+
+    const auto mappedCommands =
+        reinterpret_cast< const MappedCommand* >( data + commandsOffset );
+
+    const auto mappedMetrics =
+        reinterpret_cast< const MappedPathMetrics* >( data + metricsOffset );
+
+    const auto elements =
+        reinterpret_cast< const MappedElement* >( data + elementsOffset );
+
+    QVector< QskPainterCommand > commands;
+    commands.reserve( header->commandCount );
+
+    // the metrics are stored for the non empty paths only
+    quint32 pathCount = 0;
+
+    for ( uint i = 0; i < header->commandCount; i++ )
+    {
+        const auto& command = mappedCommands[ i ];
+
+        if ( command.type == QskPainterCommand::Path )
+        {
+            if ( quint64( command.offset ) + command.count > header->elementCount )
+                return QskGraphic();
+
+            if ( !qskReadMappedPath( command, elements, commands ) )
+                return QskGraphic();
+
+            if ( !commands.last().path()->isEmpty() )
+                pathCount++;
+
+            continue;
+        }
+
+        if ( quint64( command.offset ) + command.count > header->dataSize )
+            return QskGraphic();
+
+        // no deep copy
+        const auto bytes = QByteArray::fromRawData(
+            data + dataOffset + command.offset, command.count );
+
+        QDataStream stream( bytes );
+        stream.setByteOrder( QDataStream::BigEndian );
+
+        switch ( command.type )
+        {
+            case QskPainterCommand::Pixmap:
+            {
+                qskReadPixmapData( stream, commands );
+                break;
+            }
+            case QskPainterCommand::Image:
+            {
+                qskReadImageData( stream, commands );
+                break;
+            }
+            case QskPainterCommand::State:
+            {
+                qskReadStateData( stream, commands );
+                break;
+            }
+            default:
+                return QskGraphic();
+        }
+
+        if ( stream.status() != QDataStream::Ok )
+            return QskGraphic();
+    }
+
+    if ( pathCount != header->pathCount )
+    {
+        qWarning( "QskGraphicIO::read: inconsistent path metrics" );
+        return QskGraphic();
+    }
+
+    QVector< QskGraphic::PathMetrics > pathMetrics;
+    pathMetrics.reserve( header->pathCount );
+
+    for ( uint i = 0; i < header->pathCount; i++ )
+    {
+        const auto& metrics = mappedMetrics[ i ];
+
+        pathMetrics += QskGraphic::PathMetrics {
+            qskRestoreRect( metrics.pointRect ),
+            qskRestoreRect( metrics.boundingRect ),
+            metrics.scalablePen != 0 };
+    }
+
+    QskGraphic graphic;
+    graphic.setCommands( commands, pathMetrics,
+        qskRestoreRect( header->boundingRect ), qskRestoreRect( header->pointRect ),
+        static_cast< QskGraphic::CommandTypes >( header->commandTypes ) );
+
+    return graphic;
 }
 
-QskGraphic QskGraphicIO::read( const QByteArray& data )
+static bool qskReadMappedHeader( const QByteArray& data, MappedHeader& header )
 {
-    QBuffer buffer;
-    buffer.setData( data );
+    if ( data.size() < qint64( sizeof( MappedHeader ) ) )
+        return false;
 
-    return read( &buffer );
+    std::memcpy( &header, data.constData(), sizeof( MappedHeader ) );
+
+    return ( std::memcmp( header.magicNumber, qskMappedMagicNumber, 4 ) == 0 )
+        && ( header.version == MappedVersion ) && ( header.byteOrder == ByteOrderMark );
 }
 
-QskGraphic QskGraphicIO::read( QIODevice* dev )
+static QskGraphic qskLazyGraphic( const MappedHeader& header,
+    const std::function< QskGraphic() >& loader )
 {
-    if ( dev == nullptr )
-        return QskGraphic();
+    QskGraphic graphic;
 
+    if ( header.commandCount > 0 )
+    {
+        graphic.setLazyCommands( loader,
+            qskRestoreRect( header.boundingRect ), qskRestoreRect( header.pointRect ),
+            static_cast< QskGraphic::CommandTypes >( header.commandTypes ) );
+    }
+
+    return graphic;
+}
+
+static QskGraphic qskReadStream( QIODevice* dev )
+{
     QDataStream stream( dev );
     stream.setByteOrder( QDataStream::BigEndian );
 
@@ -275,29 +543,131 @@ QskGraphic QskGraphicIO::read( QIODevice* dev )
     return graphic;
 }
 
-bool QskGraphicIO::write( const QskGraphic& graphic, const QString& fileName )
+static bool qskWriteMapped( const QskGraphic& graphic, QIODevice* dev )
 {
-    QFile file( fileName );
-    if ( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) == false )
+    const auto& commands = graphic.commands();
+    const auto pathMetrics = graphic.pathMetrics();
+
+    QVector< MappedCommand > mappedCommands;
+    mappedCommands.reserve( commands.size() );
+
+    QVector< MappedElement > elements;
+
+    QByteArray data;
+
+    QDataStream stream( &data, QIODevice::WriteOnly );
+    stream.setByteOrder( QDataStream::BigEndian );
+
+    for ( const auto& command : commands )
     {
-        qWarning( "QskGraphicIO::write can't open %s", qPrintable( fileName ) );
-        return false;
+        MappedCommand mappedCommand;
+        std::memset( &mappedCommand, 0, sizeof( mappedCommand ) );
+
+        mappedCommand.type = static_cast< quint8 >( command.type() );
+
+        if ( command.type() == QskPainterCommand::Path )
+        {
+            const auto path = command.path();
+
+            mappedCommand.fillRule = static_cast< quint8 >( path->fillRule() );
+            mappedCommand.offset = elements.size();
+            mappedCommand.count = path->elementCount();
+
+            for ( int i = 0; i < path->elementCount(); i++ )
+            {
+                const auto element = path->elementAt( i );
+
+                MappedElement mappedElement;
+                std::memset( &mappedElement, 0, sizeof( mappedElement ) );
+
+                mappedElement.x = element.x;
+                mappedElement.y = element.y;
+                mappedElement.type = element.type;
+
+                elements += mappedElement;
+            }
+        }
+        else
+        {
+            const auto offset = stream.device()->pos();
+
+            switch ( command.type() )
+            {
+                case QskPainterCommand::Pixmap:
+                {
+                    qskWritePixmapData( *command.pixmapData(), stream );
+                    break;
+                }
+                case QskPainterCommand::Image:
+                {
+                    qskWriteImageData( *command.imageData(), stream );
+                    break;
+                }
+                case QskPainterCommand::State:
+                {
+                    qskWriteStateData( *command.stateData(), stream );
+                    break;
+                }
+                default:
+                    return false;
+            }
+
+            mappedCommand.offset = static_cast< quint32 >( offset );
+            mappedCommand.count = static_cast< quint32 >( stream.device()->pos() - offset );
+        }
+
+        mappedCommands += mappedCommand;
     }
 
-    return write( graphic, &file );
-}
+    MappedHeader header;
+    std::memset( &header, 0, sizeof( header ) );
 
-bool QskGraphicIO::write( const QskGraphic& graphic, QByteArray& data )
-{
-    QBuffer buffer( &data );
-    return write( graphic, &buffer );
+    std::memcpy( header.magicNumber, qskMappedMagicNumber, 4 );
+    header.version = MappedVersion;
+    header.byteOrder = ByteOrderMark;
+
+    header.commandCount = mappedCommands.size();
+    header.pathCount = pathMetrics.size();
+    header.elementCount = elements.size();
+    header.dataSize = data.size();
+
+    header.commandTypes = static_cast< quint32 >( graphic.commandTypes() );
+
+    qskStoreRect( graphic.boundingRect(), header.boundingRect );
+    qskStoreRect( graphic.controlPointRect(), header.pointRect );
+
+    QVector< MappedPathMetrics > mappedMetrics;
+    mappedMetrics.reserve( pathMetrics.size() );
+
+    for ( const auto& metrics : pathMetrics )
+    {
+        MappedPathMetrics mappedMetric;
+        std::memset( &mappedMetric, 0, sizeof( mappedMetric ) );
+
+        qskStoreRect( metrics.pointRect, mappedMetric.pointRect );
+        qskStoreRect( metrics.boundingRect, mappedMetric.boundingRect );
+        mappedMetric.scalablePen = metrics.scalablePen;
+
+        mappedMetrics += mappedMetric;
+    }
+
+    const auto writeData = [ dev ]( const void* buffer, qint64 size )
+    {
+        return dev->write( static_cast< const char* >( buffer ), size ) == size;
+    };
+
+    return writeData( &header, sizeof( header ) )
+        && writeData( mappedCommands.constData(),
+            mappedCommands.size() * sizeof( MappedCommand ) )
+        && writeData( mappedMetrics.constData(),
+            mappedMetrics.size() * sizeof( MappedPathMetrics ) )
+        && writeData( elements.constData(),
+            elements.size() * sizeof( MappedElement ) )
+        && writeData( data.constData(), data.size() );
 }
 
-bool QskGraphicIO::write( const QskGraphic& graphic, QIODevice* dev )
+static bool qskWriteStream( const QskGraphic& graphic, QIODevice* dev )
 {
-    if ( dev == nullptr )
-        return false;
-
     QDataStream stream( dev );
     stream.setByteOrder( QDataStream::BigEndian );
     stream.writeRawData( qskMagicNumber, 4 );
@@ -343,3 +713,115 @@ bool QskGraphicIO::write( const QskGraphic& graphic, QIODevice* dev )
 
     return true;
 }
+
+QskGraphic QskGraphicIO::read( const QString& fileName )
+{
+    QFile file( fileName );
+    if ( file.open( QIODevice::ReadOnly ) == false )
+    {
+        qWarning( "QskGraphicIO::read can't open %s", qPrintable( fileName ) );
+        return QskGraphic();
+    }
+
+    return read( &file );
+}
+
+QskGraphic QskGraphicIO::read( const QByteArray& data )
+{
+    if ( data.startsWith( qskMappedMagicNumber ) )
+        return qskReadMapped( data.constData(), data.size() );
+
+    QBuffer buffer;
+    buffer.setData( data );
+    buffer.open( QIODevice::ReadOnly );
+
+    return read( &buffer );
+}
+
+QskGraphic QskGraphicIO::read( QIODevice* dev )
+{
+    if ( dev == nullptr )
+        return QskGraphic();
+
+    if ( dev->peek( 4 ) == QByteArray::fromRawData( qskMappedMagicNumber, 4 ) )
+    {
+        if ( auto file = qobject_cast< QFile* >( dev ) )
+        {
+            const auto size = file->size() - file->pos();
+
+            if ( auto data = file->map( file->pos(), size ) )
+            {
+                const auto graphic = qskReadMapped(
+                    reinterpret_cast< const char* >( data ), size );
+
+                file->unmap( data );
+                return graphic;
+            }
+        }
+
+        // not mappable: reading it into memory
+        const auto data = dev->readAll();
+        return qskReadMapped( data.constData(), data.size() );
+    }
+
+    return qskReadStream( dev );
+}
+
+QskGraphic QskGraphicIO::readLazy( const QString& fileName )
+{
+    QFile file( fileName );
+    if ( file.open( QIODevice::ReadOnly ) == false )
+    {
+        qWarning( "QskGraphicIO::readLazy can't open %s", qPrintable( fileName ) );
+        return QskGraphic();
+    }
+
+    MappedHeader header;
+    if ( !qskReadMappedHeader( file.peek( sizeof( MappedHeader ) ), header ) )
+        return read( &file );
+
+    return qskLazyGraphic( header, [ fileName ]() { return read( fileName ); } );
+}
+
+QskGraphic QskGraphicIO::readLazy( const QByteArray& data )
+{
+    MappedHeader header;
+    if ( !qskReadMappedHeader( data, header ) )
+        return read( data );
+
+    return qskLazyGraphic( header, [ data ]() { return read( data ); } );
+}
+
+bool QskGraphicIO::write( const QskGraphic& graphic,
+    const QString& fileName, Format format )
+{
+    QFile file( fileName );
+    if ( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) == false )
+    {
+        qWarning( "QskGraphicIO::write can't open %s", qPrintable( fileName ) );
+        return false;
+    }
+
+    return write( graphic, &file, format );
+}
+
+bool QskGraphicIO::write( const QskGraphic& graphic,
+    QByteArray& data, Format format )
+{
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+
+    return write( graphic, &buffer, format );
+}
+
+bool QskGraphicIO::write( const QskGraphic& graphic,
+    QIODevice* dev, Format format )
+{
+    if ( dev == nullptr )
+        return false;
+
+    if ( format == MappedFormat )
+        return qskWriteMapped( graphic, dev );
+
+    return qskWriteStream( graphic, dev );
+}
@@ -15,13 +15,46 @@ class QByteArray;
 
 namespace QskGraphicIO
 {
+    enum Format
+    {
+        // the commands serialized by QDataStream: "QSKG"
+        StreamFormat,
+
+        /*
+            A flat layout of aligned records: "QSKM"
+
+            The coordinates of all paths are stored in one array, and
+            the metrics, that are calculated when recording the commands,
+            are stored too. So a file can be memory mapped and loaded
+            without replaying the commands.
+
+            As values are stored in the byte order of the machine,
+            files can't be exchanged between little and big endian systems.
+         */
+        MappedFormat
+    };
+
+    // the format is detected from the magic number
     QSK_EXPORT QskGraphic read( const QString& fileName );
     QSK_EXPORT QskGraphic read( const QByteArray& data );
     QSK_EXPORT QskGraphic read( QIODevice* dev );
 
-    QSK_EXPORT bool write( const QskGraphic&, const QString& fileName );
-    QSK_EXPORT bool write( const QskGraphic&, QByteArray& data );
-    QSK_EXPORT bool write( const QskGraphic&, QIODevice* dev );
+    /*
+        Reading only the header of MappedFormat, what is enough for
+        the metrics of the graphic. The commands are decoded, when being
+        needed for the first time. Other formats are read completely.
+     */
+    QSK_EXPORT QskGraphic readLazy( const QString& fileName );
+    QSK_EXPORT QskGraphic readLazy( const QByteArray& data );
+
+    QSK_EXPORT bool write( const QskGraphic&,
+        const QString& fileName, Format = StreamFormat );
+
+    QSK_EXPORT bool write( const QskGraphic&,
+        QByteArray& data, Format = StreamFormat );
+
+    QSK_EXPORT bool write( const QskGraphic&,
+        QIODevice* dev, Format = StreamFormat );
 }
 
 #endif
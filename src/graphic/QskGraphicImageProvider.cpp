@@ -76,11 +76,11 @@ QImage QskGraphicImageProvider::requestImage(
     }
 
     const auto graphic = requestGraphic( id );
-    if ( graphic == nullptr )
+    if ( graphic.isNull() )
         return QImage();
 
-    const QSize sz = qskGraphicSize( *graphic, requestedSize, size );
-    return graphic->toImage( sz, Qt::KeepAspectRatio );
+    const QSize sz = qskGraphicSize( graphic, requestedSize, size );
+    return graphic.toImage( sz, Qt::KeepAspectRatio );
 }
 
 QPixmap QskGraphicImageProvider::requestPixmap(
@@ -97,11 +97,11 @@ QPixmap QskGraphicImageProvider::requestPixmap(
     }
 
     const auto graphic = requestGraphic( id );
-    if ( graphic == nullptr )
+    if ( graphic.isNull() )
         return QPixmap();
 
-    const QSize sz = qskGraphicSize( *graphic, requestedSize, size );
-    return graphic->toPixmap( sz, Qt::KeepAspectRatio );
+    const QSize sz = qskGraphicSize( graphic, requestedSize, size );
+    return graphic.toPixmap( sz, Qt::KeepAspectRatio );
 }
 
 QQuickTextureFactory* QskGraphicImageProvider::requestTexture(
@@ -111,17 +111,17 @@ QQuickTextureFactory* QskGraphicImageProvider::requestTexture(
         return nullptr;
 
     const auto graphic = requestGraphic( id );
-    if ( graphic == nullptr )
+    if ( graphic.isNull() )
         return nullptr;
 
-    const QSize sz = qskGraphicSize( *graphic, requestedSize, size );
-    return new QskGraphicTextureFactory( *graphic, sz );
+    const QSize sz = qskGraphicSize( graphic, requestedSize, size );
+    return new QskGraphicTextureFactory( graphic, sz );
 }
 
-const QskGraphic* QskGraphicImageProvider::requestGraphic( const QString& id ) const
+QskGraphic QskGraphicImageProvider::requestGraphic( const QString& id ) const
 {
     if ( auto graphicProvider = Qsk::graphicProvider( m_providerId ) )
         return graphicProvider->requestGraphic( id );
 
-    return nullptr;
+    return QskGraphic();
 }
@@ -29,7 +29,7 @@ class QSK_EXPORT QskGraphicImageProvider : public QQuickImageProvider
     QString graphicProviderId() const;
 
   protected:
-    const QskGraphic* requestGraphic( const QString& id ) const;
+    QskGraphic requestGraphic( const QString& id ) const;
 
   private:
     const QString m_providerId;
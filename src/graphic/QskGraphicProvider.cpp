@@ -8,16 +8,161 @@
 #include "QskSetup.h"
 
 #include <qmutex.h>
+#include <qwaitcondition.h>
+#include <qthreadpool.h>
+#include <qrunnable.h>
 #include <qcache.h>
+#include <qhash.h>
+#include <qset.h>
 #include <qdebug.h>
 #include <qurl.h>
 
 class QskGraphicProvider::PrivateData
 {
   public:
+    class LoadJob final : public QRunnable
+    {
+      public:
+        LoadJob( QskGraphicProvider* provider, const QString& id )
+            : m_provider( provider )
+            , m_id( id )
+        {
+        }
+
+        void run() override
+        {
+            auto d = m_provider->m_data.get();
+
+            {
+                QMutexLocker locker( &d->mutex );
+
+                auto it = d->pending.find( m_id );
+                if ( it == d->pending.end() || it.value() )
+                {
+                    // cancelled or taken over by a synchronous request
+                    return;
+                }
+
+                it.value() = true;
+            }
+
+            const auto graphic = d->insert( m_id, m_provider->loadGraphic( m_id ) );
+
+            if ( !graphic.isNull() )
+                Q_EMIT m_provider->graphicLoaded( m_id );
+        }
+
+      private:
+        QskGraphicProvider* m_provider;
+        const QString m_id;
+    };
+
+    // takes ownership of the graphic and returns a copy of the cached one
+    QskGraphic insert( const QString& id, const QskGraphic* graphic )
+    {
+        if ( graphic == nullptr )
+            qWarning() << "QskGraphicProvider: can't load" << id;
+
+        QMutexLocker locker( &mutex );
+
+        pending.remove( id );
+        loadCondition.wakeAll();
+
+        if ( graphic == nullptr )
+            return QskGraphic();
+
+        if ( auto cached = cache.object( id ) )
+        {
+            delete graphic;
+            return *cached;
+        }
+
+        const QskGraphic result = *graphic;
+        cacheGraphic( id, graphic );
+
+        return result;
+    }
+
+    void cacheGraphic( const QString& id, const QskGraphic* graphic )
+    {
+        /*
+            Lazy graphics are not decoded for finding out about their
+            size. They are charged with what they have allocated so far
+            and charged again, when being accessed after decoding.
+         */
+        if ( graphic->isLazy() )
+            undecodedIds.insert( id );
+        else
+            undecodedIds.remove( id );
+
+        const auto maxCost = quint64( cache.maxCost() );
+
+        // too big graphics replace all others, instead of being rejected
+        const auto cost = qBound( quint64( 1 ), graphic->sizeInBytes(), maxCost );
+
+        const auto oldCount = cache.count();
+
+        // with a cache size of 0 QCache deletes the graphic immediately
+        if ( cache.insert( id, graphic, static_cast< int >( cost ) ) )
+            evictions += oldCount + 1 - cache.count();
+    }
+
+    void updateCost( const QString& id, const QskGraphic* graphic )
+    {
+        if ( !graphic->isLazy() && undecodedIds.contains( id ) )
+            cacheGraphic( id, cache.take( id ) );
+    }
+
+    void updateCosts()
+    {
+        const auto ids = undecodedIds;
+
+        for ( const auto& id : ids )
+        {
+            if ( auto graphic = cache.object( id ) )
+                updateCost( id, graphic );
+            else
+                undecodedIds.remove( id );
+        }
+    }
+
+    // a copy, as the cache might drop the graphic, when unlocking
+    QskGraphic cachedGraphic( const QString& id )
+    {
+        if ( auto graphic = cache.object( id ) )
+        {
+            hits++;
+
+            const QskGraphic result = *graphic;
+            updateCost( id, graphic );
+
+            return result;
+        }
+
+        misses++;
+        return QskGraphic();
+    }
+
     // caching of graphics
-    QCache< QString, const QskGraphic > cache;
+    QCache< QString, const QskGraphic > cache { 16 * 1024 * 1024 };
     QMutex mutex;
+
+    // lazy graphics, that have not been decoded, when being cached
+    QSet< QString > undecodedIds;
+
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 evictions = 0;
+
+    /*
+        ids of the graphics, that are queued for being loaded.
+        The value indicates, that loading has already been started.
+     */
+    QHash< QString, bool > pending;
+    QWaitCondition loadCondition;
+
+    QThreadPool threadPool;
+    bool isThreadSafe = false;
 };
 
 QskGraphicProvider::QskGraphicProvider( QObject* parent )
@@ -28,6 +173,12 @@ QskGraphicProvider::QskGraphicProvider( QObject* parent )
 
 QskGraphicProvider::~QskGraphicProvider()
 {
+    /*
+        Too late for providers, that load with their own members,
+        but those are thread-safe ones, that have to cancel loading
+        in their destructor.
+     */
+    cancelLoading();
 }
 
 void QskGraphicProvider::setCacheSize( int size )
@@ -48,45 +199,140 @@ int QskGraphicProvider::cacheSize() const
 void QskGraphicProvider::clearCache()
 {
     QMutexLocker locker( &m_data->mutex );
+
     m_data->cache.clear();
+    m_data->undecodedIds.clear();
 }
 
-const QskGraphic* QskGraphicProvider::requestGraphic( const QString& id ) const
+QskGraphicProvider::CacheStatistics QskGraphicProvider::cacheStatistics() const
 {
-    const QskGraphic* graphic = nullptr;
+    QMutexLocker locker( &m_data->mutex );
 
-    {
-        QMutexLocker locker( &m_data->mutex );
-        graphic = m_data->cache.object( id );
-    }
+    // lazy graphics might have been decoded in the meantime
+    m_data->updateCosts();
+
+    const auto& cache = m_data->cache;
 
-    if ( graphic == nullptr )
+    CacheStatistics statistics;
+    statistics.count = cache.count();
+    statistics.bytes = cache.totalCost();
+    statistics.maxBytes = cache.maxCost();
+    statistics.hits = m_data->hits;
+    statistics.misses = m_data->misses;
+    statistics.evictions = m_data->evictions;
+
+    return statistics;
+}
+
+void QskGraphicProvider::resetCacheStatistics()
+{
+    QMutexLocker locker( &m_data->mutex );
+
+    m_data->hits = m_data->misses = m_data->evictions = 0;
+}
+
+QskGraphic QskGraphicProvider::requestGraphic( const QString& id ) const
+{
     {
-        graphic = loadGraphic( id );
+        QMutexLocker locker( &m_data->mutex );
 
-        if ( graphic == nullptr )
-        {
-            qWarning() << "QskGraphicProvider: can't load" << id;
-            return nullptr;
-        }
+        const auto graphic = m_data->cachedGraphic( id );
+        if ( !graphic.isNull() )
+            return graphic;
 
+        while ( true )
         {
-            QMutexLocker locker( &m_data->mutex );
+            if ( auto graphic = m_data->cache.object( id ) )
+                return *graphic;
 
-            if( auto cached = m_data->cache.object( id ) )
+            auto it = m_data->pending.find( id );
+            if ( it == m_data->pending.end() )
             {
-                delete graphic;
-                graphic = cached;
+                m_data->pending.insert( id, true );
+                break;
             }
-            else
+
+            if ( !it.value() )
             {
-                const int cost = 1; // TODO ...
-                m_data->cache.insert( id, graphic, cost );
+                /*
+                    Queued, but not started: instead of waiting for
+                    all jobs in front of it we load it here
+                 */
+                it.value() = true;
+                break;
             }
+
+            // being loaded by another thread
+            m_data->loadCondition.wait( &m_data->mutex );
         }
     }
 
-    return graphic;
+    return m_data->insert( id, loadGraphic( id ) );
+}
+
+QskGraphic QskGraphicProvider::requestGraphicAsync( const QString& id ) const
+{
+    if ( !isThreadSafe() )
+        return requestGraphic( id );
+
+    QMutexLocker locker( &m_data->mutex );
+
+    const auto graphic = m_data->cachedGraphic( id );
+    if ( !graphic.isNull() )
+        return graphic;
+
+    if ( !m_data->pending.contains( id ) )
+    {
+        m_data->pending.insert( id, false );
+
+        auto provider = const_cast< QskGraphicProvider* >( this );
+        m_data->threadPool.start( new PrivateData::LoadJob( provider, id ) );
+    }
+
+    return QskGraphic();
+}
+
+void QskGraphicProvider::prefetch( const QStringList& ids ) const
+{
+    for ( const auto& id : ids )
+        requestGraphicAsync( id );
+}
+
+bool QskGraphicProvider::isLoading() const
+{
+    QMutexLocker locker( &m_data->mutex );
+    return !m_data->pending.isEmpty();
+}
+
+void QskGraphicProvider::setThreadSafe( bool on )
+{
+    if ( !on )
+        cancelLoading();
+
+    QMutexLocker locker( &m_data->mutex );
+    m_data->isThreadSafe = on;
+}
+
+bool QskGraphicProvider::isThreadSafe() const
+{
+    QMutexLocker locker( &m_data->mutex );
+    return m_data->isThreadSafe;
+}
+
+void QskGraphicProvider::cancelLoading()
+{
+    m_data->threadPool.clear();
+    m_data->threadPool.waitForDone();
+
+    QMutexLocker locker( &m_data->mutex );
+
+    /*
+        Jobs, that have been removed from the queue, leave their ids
+        behind. Synchronous requests waiting for them will load the
+        graphics on their own.
+     */
+    m_data->pending.clear();
+    m_data->loadCondition.wakeAll();
 }
 
 void Qsk::addGraphicProvider(
@@ -107,23 +353,19 @@ QskGraphic Qsk::loadGraphic( const char* source )
 
 QskGraphic Qsk::loadGraphic( const QUrl& url )
 {
-    static QskGraphic nullGraphic;
-
     QString imageId = url.toString( QUrl::RemoveScheme |
         QUrl::RemoveAuthority | QUrl::NormalizePathSegments );
 
     if ( imageId.isEmpty() )
-        return nullGraphic;
+        return QskGraphic();
 
     if ( imageId[ 0 ] == '/' )
         imageId = imageId.mid( 1 );
 
     const QString providerId = url.host();
 
-    const QskGraphic* graphic = nullptr;
-
     if ( const auto provider = qskSetup->graphicProvider( providerId ) )
-        graphic = provider->requestGraphic( imageId );
+        return provider->requestGraphic( imageId );
 
-    return graphic ? *graphic : nullGraphic;
+    return QskGraphic();
 }
@@ -9,27 +9,91 @@
 #include "QskGlobal.h"
 
 #include <qobject.h>
+#include <qstringlist.h>
 #include <memory>
 
 class QskGraphic;
 class QUrl;
 
+/*
+    Graphics can be loaded synchronously by requestGraphic() or on
+    worker threads by requestGraphicAsync() and prefetch(). Concurrent
+    requests for the same id are coalesced: the graphic is loaded only once
+    and a synchronous request waits for a pending load instead of
+    starting another one.
+
+    Asynchronous loading is only done for providers, that have declared
+    loadGraphic() to be thread-safe by setThreadSafe(). Those have to call
+    cancelLoading() in their destructor. For all other providers
+    the asynchronous API falls back to synchronous loading.
+
+    The graphics are returned by value, as the cache might drop
+    them at any time.
+ */
 class QSK_EXPORT QskGraphicProvider : public QObject
 {
+    Q_OBJECT
+
   public:
+    class CacheStatistics
+    {
+      public:
+        int count = 0;
+
+        qint64 bytes = 0;
+        qint64 maxBytes = 0;
+
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+    };
+
     QskGraphicProvider( QObject* parent = nullptr );
     ~QskGraphicProvider() override;
 
+    /*
+        The size of the cache in bytes, where the cost of a graphic
+        is QskGraphic::sizeInBytes(). A graphic, that does not fit into
+        the cache, replaces all other graphics.
+     */
     void setCacheSize( int );
     int cacheSize() const;
 
     void clearCache();
 
-    const QskGraphic* requestGraphic( const QString& id ) const;
+    CacheStatistics cacheStatistics() const;
+    void resetCacheStatistics();
+
+    // returns a null graphic, when it can't be loaded
+    QskGraphic requestGraphic( const QString& id ) const;
+
+    /*
+        Returns the graphic, when it is in the cache. Otherwise a null
+        graphic is returned, while it is loaded in the background
+        and graphicLoaded() is emitted when it is available.
+     */
+    QskGraphic requestGraphicAsync( const QString& id ) const;
+
+    // loading graphics in the background, f.e. before showing a page
+    void prefetch( const QStringList& ids ) const;
+
+    bool isLoading() const;
+
+    bool isThreadSafe() const;
+
+  Q_SIGNALS:
+    // emitted from the thread, that has loaded the graphic
+    void graphicLoaded( const QString& id );
 
   protected:
     virtual const QskGraphic* loadGraphic( const QString& id ) const = 0;
 
+    // enables loading from worker threads, see above
+    void setThreadSafe( bool );
+
+    // discards all queued loads and waits for the running ones
+    void cancelLoading();
+
     class PrivateData;
     std::unique_ptr< PrivateData > m_data;
 };
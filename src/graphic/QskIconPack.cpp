@@ -0,0 +1,393 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskIconPack.h"
+#include "QskGraphic.h"
+#include "QskGraphicIO.h"
+
+#include <qfile.h>
+#include <qsavefile.h>
+#include <qvector.h>
+
+#include <algorithm>
+#include <cstring>
+
+static const char qskPackMagicNumber[] = "QSKP";
+
+namespace
+{
+    /*
+        Layout:
+
+            PackHeader
+            PackEntry[ count ], sorted by the UTF-8 names
+            names
+            QVG data, each starting at a multiple of 8
+     */
+
+    enum
+    {
+        PackVersion = 1,
+        PackByteOrderMark = 0x0102
+    };
+
+    struct PackHeader
+    {
+        char magicNumber[ 4 ];
+        quint16 version;
+        quint16 byteOrder;
+
+        quint32 count;
+        quint32 reserved;
+    };
+
+    struct PackEntry
+    {
+        quint32 nameOffset;
+        quint32 nameSize;
+
+        quint64 dataOffset;
+        quint64 dataSize;
+    };
+
+    static_assert( sizeof( PackHeader ) == 16, "Bad PackHeader" );
+    static_assert( sizeof( PackEntry ) == 24, "Bad PackEntry" );
+}
+
+static inline int qskCompareNames(
+    const char* name1, int size1, const char* name2, int size2 )
+{
+    const int ret = std::memcmp( name1, name2, qMin( size1, size2 ) );
+    if ( ret != 0 )
+        return ret;
+
+    return size1 - size2;
+}
+
+class QskIconPack::PrivateData
+{
+  public:
+    ~PrivateData()
+    {
+        if ( data )
+            file.unmap( const_cast< uchar* >( data ) );
+    }
+
+    inline const PackHeader* header() const
+    {
+        return reinterpret_cast< const PackHeader* >( data );
+    }
+
+    inline const PackEntry* entries() const
+    {
+        return reinterpret_cast< const PackEntry* >( data + sizeof( PackHeader ) );
+    }
+
+    inline QByteArray name( const PackEntry& entry ) const
+    {
+        return QByteArray::fromRawData(
+            reinterpret_cast< const char* >( data + entry.nameOffset ), entry.nameSize );
+    }
+
+    inline QByteArray payload( const PackEntry& entry ) const
+    {
+        return QByteArray::fromRawData(
+            reinterpret_cast< const char* >( data + entry.dataOffset ), entry.dataSize );
+    }
+
+    QFile file;
+
+    const uchar* data = nullptr;
+    qint64 size = 0;
+};
+
+QskIconPack::QskIconPack()
+{
+}
+
+QskIconPack::QskIconPack( const QString& fileName )
+{
+    open( fileName );
+}
+
+QskIconPack::~QskIconPack()
+{
+}
+
+bool QskIconPack::open( const QString& fileName )
+{
+    close();
+
+    std::shared_ptr< PrivateData > data( new PrivateData() );
+
+    data->file.setFileName( fileName );
+    if ( !data->file.open( QIODevice::ReadOnly ) )
+    {
+        qWarning( "QskIconPack: can't open %s", qPrintable( fileName ) );
+        return false;
+    }
+
+    data->size = data->file.size();
+    if ( data->size >= qint64( sizeof( PackHeader ) ) )
+        data->data = data->file.map( 0, data->size );
+
+    if ( data->data == nullptr )
+    {
+        qWarning( "QskIconPack: can't map %s", qPrintable( fileName ) );
+        return false;
+    }
+
+    const auto header = data->header();
+
+    if ( std::memcmp( header->magicNumber, qskPackMagicNumber, 4 ) != 0
+        || header->version != PackVersion || header->byteOrder != PackByteOrderMark )
+    {
+        qWarning( "QskIconPack: %s is no compatible icon pack", qPrintable( fileName ) );
+        return false;
+    }
+
+    const auto indexSize = sizeof( PackHeader )
+        + quint64( header->count ) * sizeof( PackEntry );
+
+    if ( indexSize > quint64( data->size ) )
+    {
+        qWarning( "QskIconPack: %s is truncated", qPrintable( fileName ) );
+        return false;
+    }
+
+    /*
+        We don't check all entries here to keep opening independent of
+        the number of graphics. The ranges are checked, when accessing them.
+     */
+
+    m_data = data;
+    return true;
+}
+
+void QskIconPack::close()
+{
+    // graphics, that have not been decoded yet, keep the file open
+    m_data.reset();
+}
+
+bool QskIconPack::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+QString QskIconPack::fileName() const
+{
+    return m_data ? m_data->file.fileName() : QString();
+}
+
+int QskIconPack::count() const
+{
+    return m_data ? static_cast< int >( m_data->header()->count ) : 0;
+}
+
+QStringList QskIconPack::names() const
+{
+    QStringList names;
+
+    if ( m_data )
+    {
+        const auto entries = m_data->entries();
+        const auto count = m_data->header()->count;
+
+        names.reserve( count );
+
+        for ( uint i = 0; i < count; i++ )
+        {
+            const auto& entry = entries[ i ];
+            if ( quint64( entry.nameOffset ) + entry.nameSize <= quint64( m_data->size ) )
+                names += QString::fromUtf8( m_data->name( entry ) );
+        }
+    }
+
+    return names;
+}
+
+bool QskIconPack::contains( const QString& name ) const
+{
+    return indexOf( name ) >= 0;
+}
+
+int QskIconPack::indexOf( const QString& name ) const
+{
+    if ( m_data == nullptr )
+        return -1;
+
+    const auto utf8 = name.toUtf8();
+
+    const auto entries = m_data->entries();
+
+    int low = 0;
+    int high = static_cast< int >( m_data->header()->count ) - 1;
+
+    while ( low <= high )
+    {
+        const int mid = ( low + high ) / 2;
+        const auto& entry = entries[ mid ];
+
+        if ( quint64( entry.nameOffset ) + entry.nameSize > quint64( m_data->size ) )
+            return -1;
+
+        const auto entryName = m_data->name( entry );
+
+        const int ret = qskCompareNames( entryName.constData(), entryName.size(),
+            utf8.constData(), utf8.size() );
+
+        if ( ret < 0 )
+            low = mid + 1;
+        else if ( ret > 0 )
+            high = mid - 1;
+        else
+            return mid;
+    }
+
+    return -1;
+}
+
+QByteArray QskIconPack::rawData( const QString& name ) const
+{
+    const int index = indexOf( name );
+    if ( index < 0 )
+        return QByteArray();
+
+    const auto& entry = m_data->entries()[ index ];
+
+    if ( entry.dataOffset + entry.dataSize > quint64( m_data->size ) )
+        return QByteArray();
+
+    return m_data->payload( entry );
+}
+
+QskGraphic QskIconPack::graphic( const QString& name ) const
+{
+    const auto data = rawData( name );
+    if ( data.isEmpty() )
+        return QskGraphic();
+
+    const auto graphic = QskGraphicIO::readLazy( data );
+    if ( !graphic.isLazy() )
+        return graphic;
+
+    /*
+        The loader of QskGraphicIO::readLazy would refer to memory,
+        that is unmapped, when the pack is closed. So we replace it by one,
+        that keeps the mapping alive until the graphic has been decoded.
+     */
+
+    const auto packData = m_data;
+    const auto offset = data.constData() - reinterpret_cast< const char* >( packData->data );
+    const auto size = data.size();
+
+    const auto loader = [ packData, offset, size ]()
+    {
+        const auto bytes = QByteArray::fromRawData(
+            reinterpret_cast< const char* >( packData->data ) + offset, size );
+
+        return QskGraphicIO::read( bytes );
+    };
+
+    QskGraphic lazyGraphic;
+    lazyGraphic.setLazyCommands( loader, graphic.boundingRect(),
+        graphic.controlPointRect(), graphic.commandTypes() );
+
+    return lazyGraphic;
+}
+
+bool QskIconPack::write( const QString& fileName,
+    const QList< QPair< QString, QByteArray > >& graphics )
+{
+    struct Graphic
+    {
+        QByteArray name;
+        QByteArray data;
+    };
+
+    QVector< Graphic > sorted;
+    sorted.reserve( graphics.size() );
+
+    for ( const auto& graphic : graphics )
+        sorted += Graphic { graphic.first.toUtf8(), graphic.second };
+
+    std::sort( sorted.begin(), sorted.end(),
+        []( const Graphic& g1, const Graphic& g2 )
+        {
+            return qskCompareNames( g1.name.constData(), g1.name.size(),
+                g2.name.constData(), g2.name.size() ) < 0;
+        } );
+
+    for ( int i = 1; i < sorted.size(); i++ )
+    {
+        if ( sorted[ i ].name == sorted[ i - 1 ].name )
+        {
+            qWarning( "QskIconPack: duplicate name %s", sorted[ i ].name.constData() );
+            return false;
+        }
+    }
+
+    PackHeader header;
+    std::memset( &header, 0, sizeof( header ) );
+
+    std::memcpy( header.magicNumber, qskPackMagicNumber, 4 );
+    header.version = PackVersion;
+    header.byteOrder = PackByteOrderMark;
+    header.count = sorted.size();
+
+    QVector< PackEntry > entries( sorted.size() );
+    QByteArray names;
+
+    quint64 offset = sizeof( PackHeader ) + entries.size() * sizeof( PackEntry );
+
+    for ( int i = 0; i < sorted.size(); i++ )
+    {
+        entries[ i ].nameOffset = static_cast< quint32 >( offset + names.size() );
+        entries[ i ].nameSize = sorted[ i ].name.size();
+
+        names += sorted[ i ].name;
+    }
+
+    offset += names.size();
+
+    // aligning the QVG data, so that it can be used without copying
+    const auto padding = []( quint64 pos ) { return ( 8 - pos % 8 ) % 8; };
+
+    offset += padding( offset );
+
+    for ( int i = 0; i < sorted.size(); i++ )
+    {
+        entries[ i ].dataOffset = offset;
+        entries[ i ].dataSize = sorted[ i ].data.size();
+
+        offset += entries[ i ].dataSize;
+        offset += padding( offset );
+    }
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        qWarning( "QskIconPack: can't write %s", qPrintable( fileName ) );
+        return false;
+    }
+
+    const char zeros[ 8 ] = { 0 };
+
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    file.write( reinterpret_cast< const char* >( entries.constData() ),
+        entries.size() * sizeof( PackEntry ) );
+
+    file.write( names );
+    file.write( zeros, padding( file.pos() ) );
+
+    for ( const auto& graphic : qskAsConst( sorted ) )
+    {
+        file.write( graphic.data );
+        file.write( zeros, padding( file.pos() ) );
+    }
+
+    return file.commit();
+}
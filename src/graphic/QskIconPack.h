@@ -0,0 +1,65 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_ICON_PACK_H
+#define QSK_ICON_PACK_H
+
+#include "QskGlobal.h"
+
+#include <qbytearray.h>
+#include <qpair.h>
+#include <qstringlist.h>
+
+#include <memory>
+
+class QskGraphic;
+
+/*
+    A single file with many graphics: an index of names, sorted for
+    a binary search, followed by the QVG data of each graphic.
+
+    The file is memory mapped, so opening a pack does not depend on
+    the number of graphics, and graphics stored in
+    QskGraphicIO::MappedFormat are decoded, when being rendered
+    for the first time.
+ */
+class QSK_EXPORT QskIconPack
+{
+  public:
+    QskIconPack();
+    QskIconPack( const QString& fileName );
+
+    ~QskIconPack();
+
+    bool open( const QString& fileName );
+    void close();
+
+    bool isOpen() const;
+    QString fileName() const;
+
+    int count() const;
+    QStringList names() const;
+
+    bool contains( const QString& name ) const;
+
+    QskGraphic graphic( const QString& name ) const;
+
+    // the QVG data - without a deep copy
+    QByteArray rawData( const QString& name ) const;
+
+    // name -> QVG data
+    static bool write( const QString& fileName,
+        const QList< QPair< QString, QByteArray > >& graphics );
+
+  private:
+    Q_DISABLE_COPY( QskIconPack )
+
+    int indexOf( const QString& name ) const;
+
+    class PrivateData;
+    std::shared_ptr< PrivateData > m_data;
+};
+
+#endif
@@ -0,0 +1,58 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskIconPackProvider.h"
+#include "QskGraphic.h"
+#include "QskIconPack.h"
+
+QskIconPackProvider::QskIconPackProvider( QObject* parent )
+    : QskGraphicProvider( parent )
+    , m_pack( new QskIconPack() )
+{
+    // reading from the mapped file is thread-safe
+    setThreadSafe( true );
+}
+
+QskIconPackProvider::QskIconPackProvider(
+        const QString& fileName, QObject* parent )
+    : QskIconPackProvider( parent )
+{
+    setFileName( fileName );
+}
+
+QskIconPackProvider::~QskIconPackProvider()
+{
+    // pending loads would access m_pack
+    cancelLoading();
+}
+
+bool QskIconPackProvider::setFileName( const QString& fileName )
+{
+    cancelLoading();
+    clearCache();
+    return m_pack->open( fileName );
+}
+
+QString QskIconPackProvider::fileName() const
+{
+    return m_pack->fileName();
+}
+
+const QskIconPack& QskIconPackProvider::iconPack() const
+{
+    return *m_pack;
+}
+
+const QskGraphic* QskIconPackProvider::loadGraphic( const QString& id ) const
+{
+    if ( !m_pack->contains( id ) )
+        return nullptr;
+
+    const auto graphic = m_pack->graphic( id );
+    if ( graphic.isNull() )
+        return nullptr;
+
+    return new QskGraphic( graphic );
+}
@@ -0,0 +1,41 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_ICON_PACK_PROVIDER_H
+#define QSK_ICON_PACK_PROVIDER_H
+
+#include "QskGraphicProvider.h"
+
+class QskIconPack;
+
+/*
+    A graphic provider for the graphics of a QskIconPack. Graphics
+    in QskGraphicIO::MappedFormat are decoded on demand.
+
+        Qsk::addGraphicProvider( "icons", new QskIconPackProvider( "icons.qskp" ) );
+        ...
+        button->setGraphicSource( "image://icons/media/play" );
+ */
+class QSK_EXPORT QskIconPackProvider : public QskGraphicProvider
+{
+  public:
+    QskIconPackProvider( QObject* parent = nullptr );
+    QskIconPackProvider( const QString& fileName, QObject* parent = nullptr );
+
+    ~QskIconPackProvider() override;
+
+    bool setFileName( const QString& );
+    QString fileName() const;
+
+    const QskIconPack& iconPack() const;
+
+  protected:
+    const QskGraphic* loadGraphic( const QString& id ) const override;
+
+  private:
+    std::unique_ptr< QskIconPack > m_pack;
+};
+
+#endif
@@ -39,24 +39,54 @@ void QskBoxClipNode::setBox( const QRectF& rect,
     m_rect = rect;
     m_hash = hash;
 
-    if ( shape.isRectangle() )
+    /*
+        Even in situations, where the clipping is not rectangular, it is
+        useful to know its bounding rectangle
+     */
+    auto clipRect = qskValidOrEmptyInnerRect( rect, border.widths() );
+
+    bool isRectangular = shape.isRectangle();
+    if ( !isRectangular )
+    {
+        /*
+            When the borders are wider than the radii, the rounded
+            corners are not part of the inner area.
+         */
+        const QskBoxRenderer::Metrics metrics( rect, shape, border );
+        if ( metrics.isTotallyCropped )
+        {
+            const auto& q = metrics.innerQuad;
+            clipRect = QRectF( q.left, q.top, q.width, q.height );
+
+            isRectangular = true;
+        }
+    }
+
+    if ( isRectangular )
     {
-        if ( m_geometry.vertexCount() > 0 )
-            m_geometry.allocate( 0 );
+        /*
+            Rectangular clips are done by scissoring, what does not break
+            the batching of the clipped nodes. But when the clip node is rotated
+            the renderer falls back to the stencil buffer and needs the geometry.
+         */
+        if ( m_geometry.vertexCount() != 4 )
+            m_geometry.allocate( 4 );
 
-        setIsRectangular( true );
+        m_geometry.setDrawingMode( QSGGeometry::DrawTriangleStrip );
+
+        auto p = m_geometry.vertexDataAsPoint2D();
+        p[ 0 ].set( clipRect.left(), clipRect.top() );
+        p[ 1 ].set( clipRect.right(), clipRect.top() );
+        p[ 2 ].set( clipRect.left(), clipRect.bottom() );
+        p[ 3 ].set( clipRect.right(), clipRect.bottom() );
     }
     else
     {
-        setIsRectangular( false );
         QskBoxRenderer().renderFill( rect, shape, border, m_geometry );
     }
 
-    /*
-        Even in situations, where the clipping is not rectangular, it is
-        useful to know its bounding rectangle
-     */
-    setClipRect( qskValidOrEmptyInnerRect( rect, border.widths() ) );
+    setIsRectangular( isRectangular );
+    setClipRect( clipRect );
 
     markDirty( QSGNode::DirtyGeometry );
 }
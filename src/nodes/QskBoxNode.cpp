@@ -9,13 +9,19 @@
 #include "QskBoxRenderer.h"
 #include "QskBoxShapeMetrics.h"
 #include "QskGradient.h"
+#include "QskGradientTexture.h"
+#include "QskNodeStatistics.h"
 
+#include <qatomic.h>
 #include <qglobalstatic.h>
 #include <qsgflatcolormaterial.h>
+#include <qsgtexturematerial.h>
 #include <qsgvertexcolormaterial.h>
 
 Q_GLOBAL_STATIC( QSGVertexColorMaterial, qskMaterialVertex )
 
+static QAtomicInt qskIndexedGeometries( 0 );
+
 static inline uint qskMetricsHash(
     const QskBoxShapeMetrics& shape, const QskBoxBorderMetrics& borderMetrics )
 {
@@ -33,9 +39,79 @@ static inline uint qskColorsHash(
     return fillGradient.hash( hash );
 }
 
+static inline bool qskIsGradientTextureCandidate( const QskGradient& gradient )
+{
+    /*
+        With vertex colors we need lines for each stop, what is
+        expensive for gradients with many stops and for diagonal gradients.
+     */
+    if ( gradient.isMonochrome() )
+        return false;
+
+    if ( gradient.stopCount() <= 2 && gradient.orientation() != QskGradient::Diagonal )
+        return false;
+
+    return QskGradientTexture::isSupported();
+}
+
+static void qskRenderGradientFill( const QRectF& rect,
+    const QskBoxShapeMetrics& shape, const QskBoxBorderMetrics& borderMetrics,
+    QskGradient::Orientation orientation, QSGGeometry& geometry )
+{
+    QSGGeometry fillGeometry( QSGGeometry::defaultAttributes_Point2D(), 0 );
+
+    QskBoxRenderer renderer;
+    renderer.renderFill( rect, shape, borderMetrics, fillGeometry );
+
+    // the gradient is stretched over the inner rectangle
+    const QskBoxRenderer::Metrics metrics( rect, shape, borderMetrics );
+    const auto& quad = metrics.innerQuad;
+
+    const qreal d = quad.width * quad.width + quad.height * quad.height;
+
+    // the gradient goes from the center of the first to the center of the last pixel
+    const qreal textureWidth = QskGradientTexture::textureWidth();
+    const qreal offset = 0.5 / textureWidth;
+    const qreal scale = ( textureWidth - 1.0 ) / textureWidth;
+
+    geometry.setDrawingMode( fillGeometry.drawingMode() );
+    geometry.allocate( fillGeometry.vertexCount() );
+
+    const auto from = fillGeometry.vertexDataAsPoint2D();
+    auto to = geometry.vertexDataAsTexturedPoint2D();
+
+    for ( int i = 0; i < fillGeometry.vertexCount(); i++ )
+    {
+        const qreal x = from[ i ].x;
+        const qreal y = from[ i ].y;
+
+        qreal value;
+
+        switch ( orientation )
+        {
+            case QskGradient::Horizontal:
+                value = ( x - quad.left ) / quad.width;
+                break;
+
+            case QskGradient::Vertical:
+                value = ( y - quad.top ) / quad.height;
+                break;
+
+            default:
+                value = ( ( x - quad.left ) * quad.width
+                    + ( y - quad.top ) * quad.height ) / d;
+        }
+
+        value = qBound( 0.0, value, 1.0 );
+        to[ i ].set( x, y, offset + value * scale, 0.5f );
+    }
+}
+
 QskBoxNode::QskBoxNode()
     : m_metricsHash( 0 )
     , m_colorsHash( 0 )
+    , m_materialMode( VertexColors )
+    , m_borderNode( nullptr )
     , m_geometry( QSGGeometry::defaultAttributes_ColoredPoint2D(), 0 )
 {
     setMaterial( qskMaterialVertex );
@@ -44,6 +120,12 @@ QskBoxNode::QskBoxNode()
 
 QskBoxNode::~QskBoxNode()
 {
+    if ( m_materialMode == GradientTexture )
+    {
+        const auto textureMaterial = static_cast< QSGTextureMaterial* >( material() );
+        QskGradientTexture::releaseTexture( textureMaterial->texture() );
+    }
+
     if ( material() != qskMaterialVertex )
         delete material();
 }
@@ -72,6 +154,8 @@ void QskBoxNode::setBoxData( const QRectF& rect,
     m_colorsHash = colorsHash;
     m_rect = rect;
 
+    QskNodeStatistics::increment( QskNodeStatistics::GeometryUpdates );
+
     markDirty( QSGNode::DirtyMaterial );
     markDirty( QSGNode::DirtyGeometry );
 #endif
@@ -79,6 +163,8 @@ void QskBoxNode::setBoxData( const QRectF& rect,
     if ( rect.isEmpty() )
     {
         m_geometry.allocate( 0 );
+        updateBorderNode( false, rect, shape, borderMetrics, borderColors );
+
         return;
     }
 
@@ -98,9 +184,35 @@ void QskBoxNode::setBoxData( const QRectF& rect,
     if ( !hasBorder && !hasFill )
     {
         m_geometry.allocate( 0 );
+        updateBorderNode( false, rect, shape, borderMetrics, borderColors );
+
         return;
     }
 
+    if ( hasFill && qskIsGradientTextureCandidate( fillGradient ) )
+    {
+        const QSGTexture* oldTexture = nullptr;
+        if ( m_materialMode == GradientTexture )
+            oldTexture = static_cast< QSGTextureMaterial* >( material() )->texture();
+
+        if ( auto texture = QskGradientTexture::replaceTexture( oldTexture, fillGradient ) )
+        {
+            setMaterialMode( GradientTexture );
+
+            auto textureMaterial = static_cast< QSGTextureMaterial* >( material() );
+            textureMaterial->setTexture( texture );
+
+            qskRenderGradientFill( m_rect, shape, borderMetrics,
+                fillGradient.orientation(), m_geometry );
+
+            updateBorderNode( hasBorder, m_rect, shape, borderMetrics, borderColors );
+
+            return;
+        }
+    }
+
+    updateBorderNode( false, rect, shape, borderMetrics, borderColors );
+
     const bool isFillMonochrome = hasFill ? fillGradient.isMonochrome() : true;
     const bool isBorderMonochrome = hasBorder ? borderColors.isMonochrome() : true;
 
@@ -139,15 +251,23 @@ void QskBoxNode::setBoxData( const QRectF& rect,
 
     if ( !maybeFlat )
     {
-        setMonochrome( false );
+        setMaterialMode( VertexColors );
 
-        renderer.renderBox( m_rect, shape, borderMetrics,
-            borderColors, fillGradient, *geometry() );
+        if ( hasIndexedGeometries() )
+        {
+            renderer.renderBoxIndexed( m_rect, shape, borderMetrics,
+                borderColors, fillGradient, *geometry() );
+        }
+        else
+        {
+            renderer.renderBox( m_rect, shape, borderMetrics,
+                borderColors, fillGradient, *geometry() );
+        }
     }
     else
     {
         // all is done with one color
-        setMonochrome( true );
+        setMaterialMode( Monochrome );
 
         auto* flatMaterial = static_cast< QSGFlatColorMaterial* >( material() );
 
@@ -164,28 +284,91 @@ void QskBoxNode::setBoxData( const QRectF& rect,
     }
 }
 
-void QskBoxNode::setMonochrome( bool on )
+void QskBoxNode::setIndexedGeometries( bool on )
 {
-    const auto material = this->material();
+    qskIndexedGeometries.storeRelease( on ? 1 : 0 );
+}
 
-    if ( on == ( material != qskMaterialVertex ) )
+bool QskBoxNode::hasIndexedGeometries()
+{
+    return qskIndexedGeometries.loadAcquire() != 0;
+}
+
+void QskBoxNode::setMaterialMode( MaterialMode mode )
+{
+    if ( mode == m_materialMode )
         return;
 
+    const auto oldMaterial = material();
+
+    if ( m_materialMode == GradientTexture )
+    {
+        const auto textureMaterial = static_cast< QSGTextureMaterial* >( oldMaterial );
+        QskGradientTexture::releaseTexture( textureMaterial->texture() );
+    }
+
     m_geometry.allocate( 0 );
 
-    if ( on )
+    const QSGGeometry::AttributeSet* attributes;
+
+    switch ( mode )
     {
-        setMaterial( new QSGFlatColorMaterial() );
+        case Monochrome:
+        {
+            setMaterial( new QSGFlatColorMaterial() );
+            attributes = &QSGGeometry::defaultAttributes_Point2D();
+
+            break;
+        }
+        case GradientTexture:
+        {
+            auto textureMaterial = new QSGTextureMaterial();
+            textureMaterial->setFiltering( QSGTexture::Linear );
+
+            setMaterial( textureMaterial );
+            attributes = &QSGGeometry::defaultAttributes_TexturedPoint2D();
 
-        const QSGGeometry g( QSGGeometry::defaultAttributes_Point2D(), 0 );
-        memcpy( ( void* ) &m_geometry, ( void* ) &g, sizeof( QSGGeometry ) );
+            break;
+        }
+        default:
+        {
+            setMaterial( qskMaterialVertex );
+            attributes = &QSGGeometry::defaultAttributes_ColoredPoint2D();
+        }
     }
-    else
+
+    if ( oldMaterial != qskMaterialVertex )
+        delete oldMaterial;
+
+    const QSGGeometry g( *attributes, 0 );
+    memcpy( ( void* ) &m_geometry, ( void* ) &g, sizeof( QSGGeometry ) );
+
+    m_materialMode = mode;
+}
+
+void QskBoxNode::updateBorderNode( bool on, const QRectF& rect,
+    const QskBoxShapeMetrics& shape, const QskBoxBorderMetrics& borderMetrics,
+    const QskBoxBorderColors& borderColors )
+{
+    if ( !on )
     {
-        setMaterial( qskMaterialVertex );
-        delete material;
+        if ( m_borderNode )
+        {
+            removeChildNode( m_borderNode );
+            delete m_borderNode;
+
+            m_borderNode = nullptr;
+        }
 
-        const QSGGeometry g( QSGGeometry::defaultAttributes_ColoredPoint2D(), 0 );
-        memcpy( ( void* ) &m_geometry, ( void* ) &g, sizeof( QSGGeometry ) );
+        return;
     }
+
+    if ( m_borderNode == nullptr )
+    {
+        m_borderNode = new QskBoxNode();
+        appendChildNode( m_borderNode );
+    }
+
+    // an invalid gradient: border only
+    m_borderNode->setBoxData( rect, shape, borderMetrics, borderColors, QskGradient() );
 }
@@ -26,13 +26,36 @@ class QSK_EXPORT QskBoxNode : public QSGGeometryNode
 
     void setBoxData( const QRectF& rect, const QskGradient& );
 
+    /*
+        Sharing identical vertices of the vertex color geometries
+        by indexes - see QskBoxRenderer::renderBoxIndexed. As this
+        needs an extra pass over the vertices it is off by default.
+     */
+    static void setIndexedGeometries( bool );
+    static bool hasIndexedGeometries();
+
   private:
-    void setMonochrome( bool on );
+    enum MaterialMode : quint8
+    {
+        VertexColors,
+        Monochrome,
+        GradientTexture
+    };
+
+    void setMaterialMode( MaterialMode );
+
+    void updateBorderNode( bool on, const QRectF&, const QskBoxShapeMetrics&,
+        const QskBoxBorderMetrics&, const QskBoxBorderColors& );
 
     uint m_metricsHash;
     uint m_colorsHash;
     QRectF m_rect;
 
+    MaterialMode m_materialMode;
+
+    // the border, when the fill is done by a gradient texture
+    QskBoxNode* m_borderNode;
+
     QSGGeometry m_geometry;
 };
 
@@ -34,6 +34,16 @@ class QSK_EXPORT QskBoxRenderer
         const QskBoxShapeMetrics&, const QskBoxBorderMetrics&,
         const QskBoxBorderColors&, const QskGradient&, QSGGeometry& );
 
+    /*
+        The same as renderBox, but identical vertices - f.e. at the joints
+        between border and fill - are shared by using 16 bit indexes.
+        Falls back to renderBox, when the indexes would not reduce
+        the size of the geometry.
+     */
+    void renderBoxIndexed( const QRectF&,
+        const QskBoxShapeMetrics&, const QskBoxBorderMetrics&,
+        const QskBoxBorderColors&, const QskGradient&, QSGGeometry& );
+
     class Quad
     {
       public:
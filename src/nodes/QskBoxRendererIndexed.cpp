@@ -0,0 +1,143 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskBoxRenderer.h"
+#include "QskVertex.h"
+
+#include <qsggeometry.h>
+#include <qvarlengtharray.h>
+
+#include <cstring>
+
+namespace
+{
+    /*
+        Duplicates are found at the joints between the parts of
+        the outline, between border and fill and from the dummy lines,
+        that are inserted to match the allocated memory.
+        All of them are close to each other, so we only compare
+        with the most recent vertices instead of doing an expensive lookup.
+     */
+    class VertexWindow
+    {
+      public:
+        enum { Size = 6 };
+
+        VertexWindow()
+            : m_count( 0 )
+            , m_next( 0 )
+        {
+        }
+
+        int find( const QSGGeometry::ColoredPoint2D& point,
+            const QSGGeometry::ColoredPoint2D* vertices ) const
+        {
+            for ( int i = 0; i < m_count; i++ )
+            {
+                const auto index = m_indexes[ i ];
+                if ( std::memcmp( &vertices[ index ], &point, sizeof( point ) ) == 0 )
+                    return index;
+            }
+
+            return -1;
+        }
+
+        void insert( int index )
+        {
+            m_indexes[ m_next ] = index;
+            m_next = ( m_next + 1 ) % Size;
+
+            if ( m_count < Size )
+                m_count++;
+        }
+
+      private:
+        int m_indexes[ Size ];
+        int m_count;
+        int m_next;
+    };
+}
+
+void QskBoxRenderer::renderBoxIndexed( const QRectF& rect,
+    const QskBoxShapeMetrics& shape, const QskBoxBorderMetrics& border,
+    const QskBoxBorderColors& borderColors, const QskGradient& gradient,
+    QSGGeometry& geometry )
+{
+    Q_ASSERT( geometry.sizeOfVertex() == sizeof( QSGGeometry::ColoredPoint2D ) );
+    Q_ASSERT( geometry.indexType() == QSGGeometry::UnsignedShortType );
+
+    QSGGeometry strip( QSGGeometry::defaultAttributes_ColoredPoint2D(), 0 );
+    renderBox( rect, shape, border, borderColors, gradient, strip );
+
+    const int count = strip.vertexCount();
+    const auto points = strip.vertexDataAsColoredPoint2D();
+
+    geometry.setDrawingMode( strip.drawingMode() );
+
+    if ( count >= 0xffff || strip.drawingMode() != QSGGeometry::DrawTriangleStrip )
+    {
+        // out of the range of 16 bit indexes
+        geometry.allocate( count, 0 );
+        std::memcpy( geometry.vertexData(), points, count * sizeof( points[ 0 ] ) );
+
+        return;
+    }
+
+    QVarLengthArray< QSGGeometry::ColoredPoint2D, 256 > vertices;
+    QVarLengthArray< quint16, 256 > indexes;
+
+    VertexWindow window;
+
+    for ( int i = 0; i + 1 < count; i += 2 )
+    {
+        quint16 lineIndexes[ 2 ];
+
+        for ( int j = 0; j < 2; j++ )
+        {
+            const auto& point = points[ i + j ];
+
+            int index = window.find( point, vertices.constData() );
+            if ( index < 0 )
+            {
+                index = vertices.count();
+                vertices.append( point );
+
+                window.insert( index );
+            }
+
+            lineIndexes[ j ] = static_cast< quint16 >( index );
+        }
+
+        const int n = indexes.count();
+        if ( n >= 2 && indexes[ n - 2 ] == lineIndexes[ 0 ]
+            && indexes[ n - 1 ] == lineIndexes[ 1 ] )
+        {
+            // repeating a line adds degenerate triangles only
+            continue;
+        }
+
+        indexes.append( lineIndexes, 2 );
+    }
+
+    const auto indexedSize = vertices.count() * sizeof( vertices[ 0 ] )
+        + indexes.count() * sizeof( indexes[ 0 ] );
+
+    if ( indexedSize >= count * sizeof( points[ 0 ] ) )
+    {
+        // not enough duplicates to justify the indexes
+        geometry.allocate( count, 0 );
+        std::memcpy( geometry.vertexData(), points, count * sizeof( points[ 0 ] ) );
+
+        return;
+    }
+
+    geometry.allocate( vertices.count(), indexes.count() );
+
+    std::memcpy( geometry.vertexData(), vertices.constData(),
+        vertices.count() * sizeof( vertices[ 0 ] ) );
+
+    std::memcpy( geometry.indexDataAsUShort(), indexes.constData(),
+        indexes.count() * sizeof( indexes[ 0 ] ) );
+}
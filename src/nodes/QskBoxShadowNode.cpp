@@ -0,0 +1,535 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskBoxShadowNode.h"
+#include "QskBoxShapeMetrics.h"
+#include "QskNodeStatistics.h"
+#include "QskShadowMetrics.h"
+
+#include <qcolor.h>
+#include <qglobalstatic.h>
+#include <qhash.h>
+#include <qimage.h>
+#include <qmath.h>
+#include <qmutex.h>
+#include <qpainter.h>
+#include <qpainterpath.h>
+#include <qquickwindow.h>
+#include <qset.h>
+#include <qsgtexture.h>
+#include <qvector.h>
+
+namespace
+{
+    class ShadowKey
+    {
+      public:
+        inline bool operator==( const ShadowKey& other ) const
+        {
+            if ( blurRadius != other.blurRadius || rgb != other.rgb
+                || devicePixelRatio != other.devicePixelRatio )
+            {
+                return false;
+            }
+
+            for ( int i = 0; i < 4; i++ )
+            {
+                if ( radii[ i ] != other.radii[ i ] )
+                    return false;
+            }
+
+            return true;
+        }
+
+        qreal blurRadius;
+        QSizeF radii[ 4 ]; // indexed by Qt::Corner
+        QRgb rgb;
+        qreal devicePixelRatio;
+    };
+
+    inline uint qHash( const ShadowKey& key, uint seed = 0 )
+    {
+        uint h = ::qHash( key.blurRadius, seed );
+
+        for ( const auto& radius : key.radii )
+        {
+            h = ::qHash( radius.width(), h );
+            h = ::qHash( radius.height(), h );
+        }
+
+        h = ::qHash( key.rgb, h );
+        h = ::qHash( key.devicePixelRatio, h );
+
+        return h;
+    }
+
+    /*
+        The extents of the corner patches: the blurred edge outside
+        of the box, the corner radius and the blurred edge inside.
+        In between there is one pixel, that gets stretched.
+     */
+    class Patches
+    {
+      public:
+        Patches( const ShadowKey& key )
+        {
+            const auto& r = key.radii;
+            const qreal b = 2.0 * key.blurRadius;
+
+            left = b + qMax( r[ Qt::TopLeftCorner ].width(), r[ Qt::BottomLeftCorner ].width() );
+            right = b + qMax( r[ Qt::TopRightCorner ].width(), r[ Qt::BottomRightCorner ].width() );
+            top = b + qMax( r[ Qt::TopLeftCorner ].height(), r[ Qt::TopRightCorner ].height() );
+            bottom = b + qMax( r[ Qt::BottomLeftCorner ].height(), r[ Qt::BottomRightCorner ].height() );
+
+            const qreal ratio = key.devicePixelRatio;
+
+            pixelLeft = qCeil( left * ratio );
+            pixelRight = qCeil( right * ratio );
+            pixelTop = qCeil( top * ratio );
+            pixelBottom = qCeil( bottom * ratio );
+        }
+
+        inline QSize imageSize() const
+        {
+            return QSize( pixelLeft + pixelRight + 1, pixelTop + pixelBottom + 1 );
+        }
+
+        qreal left, right, top, bottom;
+        int pixelLeft, pixelRight, pixelTop, pixelBottom;
+    };
+}
+
+static QVector< float > qskGaussianKernel( int radius )
+{
+    QVector< float > kernel( 2 * radius + 1 );
+
+    const float sigma = qMax( 0.5f * radius, 0.5f );
+    const float f = 1.0f / ( 2.0f * sigma * sigma );
+
+    float sum = 0.0f;
+
+    for ( int i = -radius; i <= radius; i++ )
+    {
+        const float v = std::exp( -( i * i ) * f );
+
+        kernel[ i + radius ] = v;
+        sum += v;
+    }
+
+    for ( auto& v : kernel )
+        v /= sum;
+
+    return kernel;
+}
+
+static void qskBlurAlpha( QImage& image, int radius )
+{
+    if ( radius <= 0 )
+        return;
+
+    const auto kernel = qskGaussianKernel( radius );
+
+    const int w = image.width();
+    const int h = image.height();
+
+    QVector< float > buffer( w * h );
+
+    for ( int y = 0; y < h; y++ )
+    {
+        const auto line = image.constScanLine( y );
+        auto values = buffer.data() + y * w;
+
+        for ( int x = 0; x < w; x++ )
+        {
+            const int from = qMax( x - radius, 0 );
+            const int to = qMin( x + radius, w - 1 );
+
+            float v = 0.0f;
+            for ( int i = from; i <= to; i++ )
+                v += line[ i ] * kernel[ i - x + radius ];
+
+            values[ x ] = v;
+        }
+    }
+
+    for ( int y = 0; y < h; y++ )
+    {
+        auto line = image.scanLine( y );
+
+        const int from = qMax( y - radius, 0 );
+        const int to = qMin( y + radius, h - 1 );
+
+        for ( int x = 0; x < w; x++ )
+        {
+            float v = 0.0f;
+            for ( int i = from; i <= to; i++ )
+                v += buffer[ i * w + x ] * kernel[ i - y + radius ];
+
+            line[ x ] = static_cast< uchar >( qBound( 0, qRound( v ), 255 ) );
+        }
+    }
+}
+
+static QPainterPath qskRoundedRect( const QRectF& r, const QSizeF radii[] )
+{
+    const auto& tl = radii[ Qt::TopLeftCorner ];
+    const auto& tr = radii[ Qt::TopRightCorner ];
+    const auto& bl = radii[ Qt::BottomLeftCorner ];
+    const auto& br = radii[ Qt::BottomRightCorner ];
+
+    QPainterPath path;
+
+    path.moveTo( r.left() + tl.width(), r.top() );
+    path.lineTo( r.right() - tr.width(), r.top() );
+    path.arcTo( QRectF( r.right() - 2 * tr.width(), r.top(),
+        2 * tr.width(), 2 * tr.height() ), 90.0, -90.0 );
+
+    path.lineTo( r.right(), r.bottom() - br.height() );
+    path.arcTo( QRectF( r.right() - 2 * br.width(), r.bottom() - 2 * br.height(),
+        2 * br.width(), 2 * br.height() ), 0.0, -90.0 );
+
+    path.lineTo( r.left() + bl.width(), r.bottom() );
+    path.arcTo( QRectF( r.left(), r.bottom() - 2 * bl.height(),
+        2 * bl.width(), 2 * bl.height() ), 270.0, -90.0 );
+
+    path.lineTo( r.left(), r.top() + tl.height() );
+    path.arcTo( QRectF( r.left(), r.top(),
+        2 * tl.width(), 2 * tl.height() ), 180.0, -90.0 );
+
+    path.closeSubpath();
+
+    return path;
+}
+
+static QImage qskShadowImage( const ShadowKey& key )
+{
+    const Patches patches( key );
+    const auto size = patches.imageSize();
+
+    const qreal ratio = key.devicePixelRatio;
+    const qreal blur = key.blurRadius * ratio;
+
+    QImage alphaImage( size, QImage::Format_Alpha8 );
+    alphaImage.fill( 0 );
+
+    {
+        QSizeF radii[ 4 ];
+        for ( int i = 0; i < 4; i++ )
+            radii[ i ] = key.radii[ i ] * ratio;
+
+        const QRectF rect( blur, blur,
+            size.width() - 2 * blur, size.height() - 2 * blur );
+
+        QPainter painter( &alphaImage );
+        painter.setRenderHint( QPainter::Antialiasing, true );
+        painter.fillPath( qskRoundedRect( rect, radii ), Qt::black );
+    }
+
+    qskBlurAlpha( alphaImage, qCeil( blur ) );
+
+    const auto rgb = key.rgb;
+
+    QImage image( size, QImage::Format_ARGB32_Premultiplied );
+
+    for ( int y = 0; y < size.height(); y++ )
+    {
+        const auto alphaLine = alphaImage.constScanLine( y );
+        auto line = reinterpret_cast< QRgb* >( image.scanLine( y ) );
+
+        for ( int x = 0; x < size.width(); x++ )
+        {
+            const int alpha = alphaLine[ x ] * qAlpha( rgb ) / 255;
+            line[ x ] = qPremultiply( qRgba( qRed( rgb ), qGreen( rgb ), qBlue( rgb ), alpha ) );
+        }
+    }
+
+    return image;
+}
+
+namespace
+{
+    /*
+        Shadow textures are shared between the nodes of a window
+        and deleted, when the last node using them is gone.
+     */
+    class ShadowCache
+    {
+      public:
+        ~ShadowCache()
+        {
+            for ( const auto& entries : qskAsConst( m_windows ) )
+            {
+                for ( const auto& entry : entries )
+                    delete entry.texture;
+            }
+        }
+
+        QSGTexture* acquire( QQuickWindow* window, const ShadowKey& key )
+        {
+            QMutexLocker locker( &m_mutex );
+
+            if ( !m_connectedWindows.contains( window ) )
+            {
+                /*
+                    The entries are removed, when the scene graph gets
+                    invalidated, but a window might initialize its scene
+                    graph again. So we remember the connected windows
+                    until they are destroyed.
+                 */
+                QObject::connect( window, &QQuickWindow::sceneGraphInvalidated,
+                    window, [ this, window ] { removeWindow( window, false ); },
+                    Qt::DirectConnection );
+
+                QObject::connect( window, &QObject::destroyed,
+                    window, [ this, window ] { removeWindow( window, true ); },
+                    Qt::DirectConnection );
+
+                m_connectedWindows += window;
+            }
+
+            auto& entries = m_windows[ window ];
+
+            auto it = entries.find( key );
+            if ( it == entries.end() )
+            {
+                QskNodeStatistics::increment( QskNodeStatistics::TextureUploads );
+
+                const auto texture = window->createTextureFromImage( qskShadowImage( key ) );
+                it = entries.insert( key, { texture, 0 } );
+            }
+
+            it->refCount++;
+            return it->texture;
+        }
+
+        void release( QQuickWindow* window, const QSGTexture* texture )
+        {
+            QMutexLocker locker( &m_mutex );
+
+            auto w = m_windows.find( window );
+            if ( w == m_windows.end() )
+                return;
+
+            auto& entries = w.value();
+
+            for ( auto it = entries.begin(); it != entries.end(); ++it )
+            {
+                if ( it->texture == texture )
+                {
+                    if ( --it->refCount == 0 )
+                    {
+                        delete it->texture;
+                        entries.erase( it );
+                    }
+
+                    break;
+                }
+            }
+        }
+
+      private:
+        class Entry
+        {
+          public:
+            QSGTexture* texture;
+            int refCount;
+        };
+
+        void removeWindow( const QQuickWindow* window, bool disconnected )
+        {
+            QHash< ShadowKey, Entry > entries;
+
+            {
+                QMutexLocker locker( &m_mutex );
+                entries = m_windows.take( window );
+
+                if ( disconnected )
+                    m_connectedWindows.remove( window );
+            }
+
+            for ( const auto& entry : qskAsConst( entries ) )
+                delete entry.texture;
+        }
+
+        QMutex m_mutex;
+        QHash< const QQuickWindow*, QHash< ShadowKey, Entry > > m_windows;
+        QSet< const QQuickWindow* > m_connectedWindows;
+    };
+}
+
+Q_GLOBAL_STATIC( ShadowCache, qskShadowCache )
+
+static inline uint qskShadowHash( const QRectF& rect,
+    const ShadowKey& key, QQuickWindow* window )
+{
+    uint hash = qHash( key, 14000 );
+
+    hash = qHash( rect.x(), hash );
+    hash = qHash( rect.y(), hash );
+    hash = qHash( rect.width(), hash );
+    hash = qHash( rect.height(), hash );
+
+    return qHash( window, hash );
+}
+
+QskBoxShadowNode::QskBoxShadowNode()
+    : m_hash( 0 )
+    , m_window( nullptr )
+    , m_geometry( QSGGeometry::defaultAttributes_TexturedPoint2D(), 0 )
+{
+    m_geometry.setDrawingMode( QSGGeometry::DrawTriangles );
+    m_material.setFiltering( QSGTexture::Linear );
+
+    setGeometry( &m_geometry );
+    setMaterial( &m_material );
+}
+
+QskBoxShadowNode::~QskBoxShadowNode()
+{
+    releaseTexture();
+}
+
+void QskBoxShadowNode::setShadowData( QQuickWindow* window, const QRectF& boxRect,
+    const QskBoxShapeMetrics& shape, const QskShadowMetrics& shadowMetrics,
+    const QColor& color )
+{
+    const auto metrics = shadowMetrics.toAbsolute( boxRect.size() );
+    const auto rect = metrics.shadowRect( boxRect );
+
+    if ( window == nullptr || rect.isEmpty() || color.alpha() == 0 )
+    {
+        m_hash = 0;
+        releaseTexture();
+
+        if ( m_geometry.vertexCount() > 0 )
+        {
+            m_geometry.allocate( 0 );
+            markDirty( QSGNode::DirtyGeometry );
+        }
+
+        return;
+    }
+
+    ShadowKey key;
+    key.blurRadius = qMax( metrics.blurRadius(), 0.0 );
+    key.rgb = color.rgba();
+    key.devicePixelRatio = window->effectiveDevicePixelRatio();
+
+    {
+        const auto absoluteShape = shape.toAbsolute( boxRect.size() );
+
+        const qreal spread = metrics.spreadRadius();
+        const qreal maxWidth = 0.5 * rect.width();
+        const qreal maxHeight = 0.5 * rect.height();
+
+        for ( int i = 0; i < 4; i++ )
+        {
+            auto radius = absoluteShape.radius( static_cast< Qt::Corner >( i ) );
+
+            // the spread radius enlarges rounded corners only
+            if ( radius.width() > 0.0 && radius.height() > 0.0 )
+                radius += QSizeF( spread, spread );
+
+            key.radii[ i ] = QSizeF(
+                qBound( 0.0, radius.width(), maxWidth ),
+                qBound( 0.0, radius.height(), maxHeight ) );
+        }
+    }
+
+    const auto hash = qskShadowHash( rect, key, window );
+    if ( hash == m_hash )
+        return;
+
+    m_hash = hash;
+
+    auto texture = qskShadowCache->acquire( window, key );
+
+    // releasing after acquiring, so that a shared texture survives
+    releaseTexture();
+
+    m_window = window;
+    m_material.setTexture( texture );
+
+    markDirty( QSGNode::DirtyMaterial | QSGNode::DirtySubtreeBlocked );
+
+    const Patches patches( key );
+    const auto imageSize = patches.imageSize();
+
+    const auto r = rect.adjusted( -key.blurRadius, -key.blurRadius,
+        key.blurRadius, key.blurRadius );
+
+    // when the box is smaller than the corners, the patches get squeezed
+
+    qreal x1 = r.left() + patches.left;
+    qreal x2 = r.right() - patches.right;
+
+    if ( x1 > x2 )
+        x1 = x2 = r.left() + r.width() * patches.left / ( patches.left + patches.right );
+
+    qreal y1 = r.top() + patches.top;
+    qreal y2 = r.bottom() - patches.bottom;
+
+    if ( y1 > y2 )
+        y1 = y2 = r.top() + r.height() * patches.top / ( patches.top + patches.bottom );
+
+    const float xs[] = { float( r.left() ), float( x1 ), float( x2 ), float( r.right() ) };
+    const float ys[] = { float( r.top() ), float( y1 ), float( y2 ), float( r.bottom() ) };
+
+    const float w = imageSize.width();
+    const float h = imageSize.height();
+
+    const float txs[] = { 0.0f, patches.pixelLeft / w, ( patches.pixelLeft + 1 ) / w, 1.0f };
+    const float tys[] = { 0.0f, patches.pixelTop / h, ( patches.pixelTop + 1 ) / h, 1.0f };
+
+    m_geometry.allocate( 9 * 6 );
+
+    auto p = m_geometry.vertexDataAsTexturedPoint2D();
+
+    for ( int row = 0; row < 3; row++ )
+    {
+        for ( int col = 0; col < 3; col++ )
+        {
+            const float x1 = xs[ col ];
+            const float x2 = xs[ col + 1 ];
+            const float y1 = ys[ row ];
+            const float y2 = ys[ row + 1 ];
+
+            const float tx1 = txs[ col ];
+            const float tx2 = txs[ col + 1 ];
+            const float ty1 = tys[ row ];
+            const float ty2 = tys[ row + 1 ];
+
+            p++->set( x1, y1, tx1, ty1 );
+            p++->set( x2, y1, tx2, ty1 );
+            p++->set( x1, y2, tx1, ty2 );
+
+            p++->set( x2, y1, tx2, ty1 );
+            p++->set( x2, y2, tx2, ty2 );
+            p++->set( x1, y2, tx1, ty2 );
+        }
+    }
+
+    markDirty( QSGNode::DirtyGeometry );
+}
+
+bool QskBoxShadowNode::isSubtreeBlocked() const
+{
+    // the texture material can't be used without a texture
+    return m_material.texture() == nullptr;
+}
+
+void QskBoxShadowNode::releaseTexture()
+{
+    if ( auto texture = m_material.texture() )
+    {
+        if ( !qskShadowCache.isDestroyed() )
+            qskShadowCache->release( m_window, texture );
+
+        m_material.setTexture( nullptr );
+        markDirty( QSGNode::DirtySubtreeBlocked );
+    }
+
+    m_window = nullptr;
+}
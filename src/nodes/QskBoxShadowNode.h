@@ -0,0 +1,52 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_BOX_SHADOW_NODE_H
+#define QSK_BOX_SHADOW_NODE_H
+
+#include "QskGlobal.h"
+
+#include <qsgnode.h>
+#include <qsgtexturematerial.h>
+
+class QskBoxShapeMetrics;
+class QskShadowMetrics;
+class QQuickWindow;
+class QColor;
+
+/*
+    QskBoxShadowNode displays the blurred shadow of a box.
+
+    The shadow is a stretched nine-patch texture: only the corners,
+    including the blurred edges, are rasterized. Textures are shared
+    between all nodes of a window with the same blur radius,
+    corner radii ( after applying the spread radius ) and color,
+    so that f.e. all cards of a grid end up in the same texture
+    and can be batched by the scene graph.
+ */
+class QSK_EXPORT QskBoxShadowNode : public QSGGeometryNode
+{
+  public:
+    QskBoxShadowNode();
+    ~QskBoxShadowNode() override;
+
+    void setShadowData( QQuickWindow*, const QRectF& boxRect,
+        const QskBoxShapeMetrics&, const QskShadowMetrics&, const QColor& );
+
+    bool isSubtreeBlocked() const override;
+
+  private:
+    void releaseTexture();
+
+    uint m_hash;
+
+    // the window, that has created the texture
+    QQuickWindow* m_window;
+
+    QSGGeometry m_geometry;
+    QSGTextureMaterial m_material;
+};
+
+#endif
@@ -0,0 +1,318 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskGradientTexture.h"
+#include "QskGradient.h"
+#include "QskNodeStatistics.h"
+
+#include <qglobalstatic.h>
+#include <qhash.h>
+#include <qimage.h>
+#include <qmutex.h>
+#include <qvector.h>
+
+#include <qopenglcontext.h>
+
+QSK_QT_PRIVATE_BEGIN
+#include <private/qsgtexture_p.h>
+QSK_QT_PRIVATE_END
+
+static const int qskTextureWidth = 256;
+
+static inline uint qskStopsHash( const QVector< QskGradientStop >& stops )
+{
+    uint hash = 15000;
+
+    for ( const auto& stop : stops )
+        hash = stop.hash( hash );
+
+    return hash;
+}
+
+static QImage qskGradientImage( const QVector< QskGradientStop >& stops )
+{
+    // the image is uploaded, when binding the texture
+    QskNodeStatistics::increment( QskNodeStatistics::TextureUploads );
+
+    QImage image( qskTextureWidth, 1, QImage::Format_ARGB32_Premultiplied );
+
+    auto line = reinterpret_cast< QRgb* >( image.scanLine( 0 ) );
+
+    int index = 0;
+
+    for ( int i = 0; i < qskTextureWidth; i++ )
+    {
+        const qreal pos = qreal( i ) / ( qskTextureWidth - 1 );
+
+        while ( index < stops.size() - 1 && stops[ index ].position() < pos )
+            index++;
+
+        QColor color;
+
+        if ( index == 0 )
+            color = stops[ 0 ].color();
+        else
+            color = QskGradientStop::interpolated( stops[ index - 1 ], stops[ index ], pos );
+
+        line[ i ] = qPremultiply( color.rgba() );
+    }
+
+    return image;
+}
+
+namespace
+{
+    class Entry
+    {
+      public:
+        QSGPlainTexture* texture;
+        int refCount;
+
+        uint hash;
+        QVector< QskGradientStop > stops;
+    };
+
+    class Cache
+    {
+      public:
+        ~Cache()
+        {
+            // the GL textures are deleted, when the context is current
+            for ( const auto entry : qskAsConst( textures ) )
+            {
+                delete entry->texture;
+                delete entry;
+            }
+
+            qDeleteAll( garbage );
+        }
+
+        Entry* find( uint hash, const QVector< QskGradientStop >& stops ) const
+        {
+            for ( auto it = entries.constFind( hash );
+                it != entries.constEnd() && it.key() == hash; ++it )
+            {
+                if ( it.value()->stops == stops )
+                    return it.value();
+            }
+
+            return nullptr;
+        }
+
+        void insert( Entry* entry )
+        {
+            entries.insert( entry->hash, entry );
+            textures.insert( entry->texture, entry );
+        }
+
+        void remove( Entry* entry )
+        {
+            entries.remove( entry->hash, entry );
+            textures.remove( entry->texture );
+        }
+
+        void rehash( Entry* entry, uint hash )
+        {
+            entries.remove( entry->hash, entry );
+            entry->hash = hash;
+            entries.insert( hash, entry );
+        }
+
+        void collectGarbage()
+        {
+            qDeleteAll( garbage );
+            garbage.clear();
+        }
+
+        // the entries by the hash of their stops
+        QMultiHash< uint, Entry* > entries;
+
+        // the same entries by their texture
+        QHash< const QSGTexture*, Entry* > textures;
+
+        /*
+            Textures, that have been released without the
+            context being current. They are deleted with the next
+            opportunity.
+         */
+        QVector< QSGPlainTexture* > garbage;
+    };
+
+    class CacheMap
+    {
+      public:
+        ~CacheMap()
+        {
+            qDeleteAll( m_caches );
+        }
+
+        Cache* cache( bool create )
+        {
+            auto context = QOpenGLContext::currentContext();
+            if ( context == nullptr )
+                return nullptr;
+
+            QMutexLocker locker( &m_mutex );
+
+            auto cache = m_caches.value( context, nullptr );
+            if ( cache == nullptr && create )
+            {
+                cache = new Cache();
+                m_caches.insert( context, cache );
+
+                QObject::connect( context, &QOpenGLContext::aboutToBeDestroyed,
+                    context, [ this, context ] { removeCache( context ); },
+                    Qt::DirectConnection );
+            }
+
+            return cache;
+        }
+
+        Cache* cache( const QSGTexture* texture )
+        {
+            QMutexLocker locker( &m_mutex );
+
+            for ( auto cache : qskAsConst( m_caches ) )
+            {
+                if ( cache->textures.contains( texture ) )
+                    return cache;
+            }
+
+            return nullptr;
+        }
+
+      private:
+        void removeCache( const QOpenGLContext* context )
+        {
+            Cache* cache;
+
+            {
+                QMutexLocker locker( &m_mutex );
+                cache = m_caches.take( context );
+            }
+
+            delete cache;
+        }
+
+        QMutex m_mutex;
+        QHash< const QOpenGLContext*, Cache* > m_caches;
+    };
+}
+
+Q_GLOBAL_STATIC( CacheMap, qskCacheMap )
+
+static inline Cache* qskCache( bool create )
+{
+    if ( qskCacheMap.isDestroyed() )
+        return nullptr;
+
+    return qskCacheMap->cache( create );
+}
+
+bool QskGradientTexture::isSupported()
+{
+    /*
+        The textures are QSGPlainTextures, that are uploaded by the
+        scene graph - for Qt6 through the RHI - and displayed by
+        QSGTextureMaterial. But like all other textures of QSkinny
+        they are shared per OpenGL context. So with Qt6 they are
+        available for the OpenGL backend of the RHI only.
+     */
+    return QOpenGLContext::currentContext() != nullptr;
+}
+
+int QskGradientTexture::textureWidth()
+{
+    return qskTextureWidth;
+}
+
+QSGTexture* QskGradientTexture::acquireTexture( const QskGradient& gradient )
+{
+    return replaceTexture( nullptr, gradient );
+}
+
+QSGTexture* QskGradientTexture::replaceTexture(
+    const QSGTexture* oldTexture, const QskGradient& gradient )
+{
+    const auto stops = gradient.stops();
+    if ( stops.isEmpty() )
+        return nullptr;
+
+    auto cache = qskCache( true );
+    if ( cache == nullptr )
+        return nullptr;
+
+    cache->collectGarbage();
+
+    const auto hash = qskStopsHash( stops );
+
+    Entry* oldEntry = nullptr;
+    if ( oldTexture )
+        oldEntry = cache->textures.value( oldTexture, nullptr );
+
+    if ( auto entry = cache->find( hash, stops ) )
+    {
+        if ( entry != oldEntry )
+        {
+            entry->refCount++;
+            releaseTexture( oldTexture );
+        }
+
+        return entry->texture;
+    }
+
+    if ( oldEntry && oldEntry->refCount == 1 )
+    {
+        /*
+            Nobody else is using the texture of the previous gradient,
+            so we can update its lookup table in place. This is what
+            happens for animated gradients.
+         */
+        oldEntry->stops = stops;
+        oldEntry->texture->setImage( qskGradientImage( stops ) );
+
+        cache->rehash( oldEntry, hash );
+
+        return oldEntry->texture;
+    }
+
+    auto texture = new QSGPlainTexture();
+    texture->setHasAlphaChannel( true );
+    texture->setImage( qskGradientImage( stops ) );
+
+    cache->insert( new Entry { texture, 1, hash, stops } );
+
+    releaseTexture( oldTexture );
+
+    return texture;
+}
+
+void QskGradientTexture::releaseTexture( const QSGTexture* texture )
+{
+    if ( texture == nullptr || qskCacheMap.isDestroyed() )
+        return;
+
+    auto cache = qskCache( false );
+
+    const bool isCurrent = cache && cache->textures.contains( texture );
+    if ( !isCurrent )
+        cache = qskCacheMap->cache( texture );
+
+    if ( cache == nullptr )
+        return;
+
+    auto entry = cache->textures.value( texture );
+    if ( --entry->refCount == 0 )
+    {
+        cache->remove( entry );
+
+        if ( isCurrent )
+            delete entry->texture;
+        else
+            cache->garbage += entry->texture;
+
+        delete entry;
+    }
+}
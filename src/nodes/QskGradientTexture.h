@@ -0,0 +1,42 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_GRADIENT_TEXTURE_H
+#define QSK_GRADIENT_TEXTURE_H
+
+#include "QskGlobal.h"
+
+class QskGradient;
+class QSGTexture;
+
+/*
+    Lookup textures for the colors of a gradient: one row of
+    textureWidth() pixels, where the first/last pixel are the colors
+    at 0.0/1.0. Filling a box with a gradient then needs texture
+    coordinates for the corners only - regardless of the number of stops.
+
+    The textures are shared by the hash of the gradient stops and are bound
+    to the OpenGL context being current, when calling the functions below.
+ */
+namespace QskGradientTexture
+{
+    // not supported by all scene graph backends
+    QSK_EXPORT bool isSupported();
+
+    QSK_EXPORT int textureWidth();
+
+    // returns nullptr, when not being supported
+    QSK_EXPORT QSGTexture* acquireTexture( const QskGradient& );
+    QSK_EXPORT void releaseTexture( const QSGTexture* );
+
+    /*
+        Releases the texture and acquires one for the gradient. When
+        the texture is not shared it might be updated in place, what
+        avoids creating new textures for animated gradients.
+     */
+    QSK_EXPORT QSGTexture* replaceTexture( const QSGTexture*, const QskGradient& );
+}
+
+#endif
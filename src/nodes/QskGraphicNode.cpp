@@ -7,19 +7,32 @@
 #include "QskGraphic.h"
 #include "QskColorFilter.h"
 #include "QskPainterCommand.h"
+#include "QskTextureAtlas.h"
+#include "QskTextureCache.h"
+
+#include <qcoreapplication.h>
+#include <qhash.h>
+#include <qimage.h>
+#include <qmutex.h>
+#include <qopenglcontext.h>
+#include <qopenglfunctions.h>
+#include <qpointer.h>
+#include <qquickwindow.h>
+#include <qrunnable.h>
+#include <qsharedpointer.h>
+#include <qthreadpool.h>
+#include <qtimer.h>
+#include <qvector.h>
 
 static inline uint qskHash(
     const QskGraphic& graphic, const QskColorFilter& colorFilter,
     QskTextureRenderer::RenderMode renderMode )
 {
-    uint hash = 12000;
+    auto hash = colorFilter.hash( 12000 );
 
-    const auto& substitutions = colorFilter.substitutions();
-    if ( substitutions.size() > 0 )
-    {
-        hash = qHashBits( substitutions.constData(),
-            substitutions.size() * sizeof( substitutions[ 0 ] ), hash );
-    }
+    // the textures are the same, no matter in which thread they have been painted
+    if ( renderMode == QskTextureRenderer::AsyncRaster )
+        renderMode = QskTextureRenderer::Raster;
 
     hash = graphic.hash( hash );
     hash = qHash( renderMode, hash );
@@ -27,13 +40,278 @@ static inline uint qskHash(
     return hash;
 }
 
+/*
+    Uploading an image into the atlas or into a texture of its own and
+    inserting it into the cache. A texture of the atlas is shared and must
+    never be owned by a node, so it is only used, when being managed
+    by the cache.
+ */
+static uint qskUploadImage( uint hash, const QSize& size,
+    const QImage& image, QRect& atlasRect, bool& isCached )
+{
+    atlasRect = QRect();
+
+    auto textureId = QskTextureAtlas::insertImage( image, &atlasRect );
+    if ( textureId )
+    {
+        isCached = QskTextureCache::insertTexture( hash, size, textureId, atlasRect );
+        if ( isCached )
+            return textureId;
+
+        QskTextureAtlas::releaseImage( textureId, atlasRect );
+        atlasRect = QRect();
+    }
+
+    textureId = QskTextureRenderer::createTextureFromImage( image );
+    isCached = QskTextureCache::insertTexture( hash, size, textureId );
+
+    return textureId;
+}
+
+static inline uint qskLevelHash( uint hash )
+{
+    return qHash( 0x4c564c, hash );
+}
+
+/*
+    The levels are power of two sizes of the larger side, using
+    the aspect ratio of the graphic. So all sizes of an animation
+    end up in the same few textures.
+ */
+static const int qskMinLevelExtent = 16;
+static const int qskMaxLevelExtent = 2048;
+
+static int qskLevelExtent( const QSize& textureSize )
+{
+    const int extent = qMax( textureSize.width(), textureSize.height() );
+    if ( extent <= 0 || extent > qskMaxLevelExtent )
+        return 0;
+
+    int levelExtent = qskMinLevelExtent;
+    while ( levelExtent < extent )
+        levelExtent *= 2;
+
+    return levelExtent;
+}
+
+static QSize qskLevelSize( const QskGraphic& graphic,
+    const QSize& textureSize, int levelExtent )
+{
+    QSizeF size = graphic.defaultSize();
+    if ( size.isEmpty() )
+        size = textureSize;
+
+    size.scale( levelExtent, levelExtent, Qt::KeepAspectRatio );
+
+    return QSize( qMax( qRound( size.width() ), 1 ), qMax( qRound( size.height() ), 1 ) );
+}
+
+static void qskDeleteTexture( uint textureId )
+{
+    if ( textureId == 0 )
+        return;
+
+    if ( auto context = QOpenGLContext::currentContext() )
+        context->functions()->glDeleteTextures( 1, &textureId );
+}
+
+namespace
+{
+    /*
+        Painting a graphic into an image in a worker thread. Jobs are
+        shared between all nodes waiting for the same image.
+     */
+    class RasterJob
+    {
+      public:
+        RasterJob( uint hash, const QSize& size,
+                const QskGraphic& graphic, const QskColorFilter& colorFilter )
+            : hash( hash )
+            , size( size )
+            , m_graphic( graphic )
+            , m_colorFilter( colorFilter )
+        {
+        }
+
+        void addWindow( QQuickWindow* window )
+        {
+            QMutexLocker locker( &m_mutex );
+
+            if ( !m_windows.contains( window ) )
+                m_windows += window;
+        }
+
+        bool isFinished() const
+        {
+            return m_finished.loadAcquire() != 0;
+        }
+
+        QImage image() const
+        {
+            return isFinished() ? m_image : QImage();
+        }
+
+        void run();
+
+        const uint hash;
+        const QSize size;
+
+      private:
+        const QskGraphic m_graphic;
+        const QskColorFilter m_colorFilter;
+
+        QImage m_image;
+        QAtomicInt m_finished;
+
+        QMutex m_mutex;
+        QVector< QPointer< QQuickWindow > > m_windows;
+    };
+
+    class Runner final : public QRunnable
+    {
+      public:
+        Runner( const QSharedPointer< RasterJob >& job )
+            : m_job( job )
+            , m_hash( job->hash )
+            , m_size( job->size )
+        {
+        }
+
+        void run() override;
+
+      private:
+        /*
+            The nodes hold the jobs. A job, that has been given up before
+            being started - f.e. for an intermediate size of an animation -
+            does not need to be painted.
+         */
+        QWeakPointer< RasterJob > m_job;
+
+        const uint m_hash;
+        const QSize m_size;
+    };
+
+    class JobTable
+    {
+      public:
+        QSharedPointer< RasterJob > job( uint hash, const QSize& size,
+            const QskGraphic& graphic, const QskColorFilter& colorFilter )
+        {
+            const auto key = qMakePair( hash, qMakePair( size.width(), size.height() ) );
+
+            QMutexLocker locker( &m_mutex );
+
+            auto job = m_jobs.value( key ).toStrongRef();
+            if ( job.isNull() )
+            {
+                job.reset( new RasterJob( hash, size, graphic, colorFilter ) );
+                m_jobs.insert( key, job );
+
+                QThreadPool::globalInstance()->start( new Runner( job ) );
+            }
+
+            return job;
+        }
+
+        void remove( const RasterJob* job )
+        {
+            const auto key = qMakePair( job->hash,
+                qMakePair( job->size.width(), job->size.height() ) );
+
+            QMutexLocker locker( &m_mutex );
+            m_jobs.remove( key );
+        }
+
+        void removeExpired( uint hash, const QSize& size )
+        {
+            const auto key = qMakePair( hash, qMakePair( size.width(), size.height() ) );
+
+            QMutexLocker locker( &m_mutex );
+
+            // there might be a new job for the same key in the meantime
+            if ( m_jobs.value( key ).isNull() )
+                m_jobs.remove( key );
+        }
+
+      private:
+        typedef QPair< uint, QPair< int, int > > Key;
+
+        QMutex m_mutex;
+        QHash< Key, QWeakPointer< RasterJob > > m_jobs;
+    };
+}
+
+Q_GLOBAL_STATIC( JobTable, qskJobTable )
+
+void Runner::run()
+{
+    if ( const auto job = m_job.toStrongRef() )
+    {
+        job->run();
+    }
+    else
+    {
+        if ( !qskJobTable.isDestroyed() )
+            qskJobTable->removeExpired( m_hash, m_size );
+    }
+}
+
+void RasterJob::run()
+{
+    m_image = QskTextureRenderer::createImageFromGraphic(
+        size, m_graphic, m_colorFilter, Qt::IgnoreAspectRatio );
+
+    m_finished.storeRelease( 1 );
+
+    if ( !qskJobTable.isDestroyed() )
+        qskJobTable->remove( this );
+
+    QVector< QPointer< QQuickWindow > > windows;
+
+    {
+        QMutexLocker locker( &m_mutex );
+        windows = m_windows;
+    }
+
+    /*
+        The upload happens in QskGraphicNode::preprocess, but we
+        need to trigger a new frame from the GUI thread for it.
+     */
+    QTimer::singleShot( 0, qApp,
+        [ windows ]
+        {
+            for ( const auto& window : windows )
+            {
+                if ( window )
+                    window->update();
+            }
+        }
+    );
+}
+
+class QskGraphicNode::PendingData
+{
+  public:
+    QSharedPointer< RasterJob > job;
+
+    // painting a raster level, that is not available from the cache
+    QSharedPointer< RasterJob > levelJob;
+
+    QQuickWindow* window = nullptr;
+    QRectF rect;
+    Qt::Orientations mirrored;
+};
+
 QskGraphicNode::QskGraphicNode()
     : m_hash( 0 )
+    , m_rasterLevels( false )
 {
 }
 
 QskGraphicNode::~QskGraphicNode()
 {
+    if ( m_cachedSize.isValid() )
+        QskTextureCache::releaseTexture( m_hash, m_cachedSize );
 }
 
 void QskGraphicNode::setGraphic(
@@ -41,7 +319,7 @@ void QskGraphicNode::setGraphic(
     QskTextureRenderer::RenderMode renderMode, const QRectF& rect,
     Qt::Orientations mirrored )
 {
-    bool isTextureDirty = isNull();
+    bool isTextureDirty = isNull() || isPending();
 
     QSize textureSize;
 
@@ -68,18 +346,253 @@ void QskGraphicNode::setGraphic(
 
     const auto hash = qskHash( graphic, colorFilter, renderMode );
     if ( hash != m_hash )
-    {
-        m_hash = hash;
         isTextureDirty = true;
+
+    if ( !isTextureDirty )
+    {
+        QskTextureNode::setTexture( window, rect,
+            QskTextureNode::textureId(), textureRect(), mirrored );
+
+        setFlag( UsePreprocess, isLevelPending() );
+        return;
+    }
+
+    /*
+        Identical graphics ( f.e. icons of a toolbar ) are very likely
+        to be rendered more than once. So we try to share the textures
+        by the cache before rendering a new one.
+     */
+
+    bool isCached = true;
+
+    QRect atlasRect;
+
+    auto textureId = QskTextureCache::acquireTexture( hash, textureSize, &atlasRect );
+    if ( textureId == 0 )
+    {
+        if ( renderMode == QskTextureRenderer::AsyncRaster )
+        {
+            if ( m_pending == nullptr )
+                m_pending.reset( new PendingData() );
+
+            if ( m_rasterLevels )
+            {
+                setLevelTexture( window, hash, textureSize,
+                    graphic, colorFilter, rect, mirrored );
+            }
+
+            auto& job = m_pending->job;
+            if ( job.isNull() || job->hash != hash || job->size != textureSize )
+                job = qskJobTable->job( hash, textureSize, graphic, colorFilter );
+
+            job->addWindow( window );
+
+            m_pending->window = window;
+            m_pending->rect = rect;
+            m_pending->mirrored = mirrored;
+
+            setFlag( UsePreprocess, true );
+
+            /*
+                Until the image is available we keep on showing the
+                previous texture. Without one we display nothing.
+             */
+            const auto r = isNull() ? QRectF() : rect;
+
+            QskTextureNode::setTexture( window, r,
+                QskTextureNode::textureId(), textureRect(), mirrored );
+
+            return;
+        }
+
+        if ( QskTextureAtlas::isCandidate( textureSize ) )
+        {
+            /*
+                Small textures are put into an atlas, so that the renderer
+                is able to batch them. As we need an image for the upload
+                we always paint with the raster paint engine here.
+             */
+            const auto image = QskTextureRenderer::createImageFromGraphic(
+                textureSize, graphic, colorFilter, Qt::IgnoreAspectRatio );
+
+            textureId = qskUploadImage( hash, textureSize, image, atlasRect, isCached );
+        }
+        else
+        {
+            textureId = QskTextureRenderer::createTextureFromGraphic(
+                renderMode, textureSize, graphic, colorFilter, Qt::IgnoreAspectRatio );
+
+            isCached = QskTextureCache::insertTexture( hash, textureSize, textureId );
+        }
+    }
+
+    if ( m_pending )
+        m_pending->job.reset();
+
+    replaceTexture( window, hash, textureSize,
+        textureId, atlasRect, isCached, rect, mirrored );
+
+    setFlag( UsePreprocess, isLevelPending() );
+}
+
+void QskGraphicNode::setRasterLevels( bool on )
+{
+    m_rasterLevels = on;
+}
+
+bool QskGraphicNode::hasRasterLevels() const
+{
+    return m_rasterLevels;
+}
+
+void QskGraphicNode::setLevelTexture( QQuickWindow* window,
+    uint hash, const QSize& textureSize, const QskGraphic& graphic,
+    const QskColorFilter& colorFilter, const QRectF& rect, Qt::Orientations mirrored )
+{
+    const int levelExtent = qskLevelExtent( textureSize );
+    if ( levelExtent == 0 )
+        return;
+
+    const auto levelSize = qskLevelSize( graphic, textureSize, levelExtent );
+    if ( levelSize == textureSize )
+        return;
+
+    // level textures have linear filtering and must not be mixed up with the others
+    const auto levelHash = qskLevelHash( hash );
+
+    /*
+        Nothing is painted on the render thread. We display the nearest
+        level, that is available from the cache: the next larger one, the
+        next smaller one or the one after the next larger one. A missing
+        next larger level is painted in a worker thread for the following
+        updates.
+     */
+    const int extents[] = { levelExtent, levelExtent / 2, levelExtent * 2 };
+
+    for ( const int extent : extents )
+    {
+        if ( extent < qskMinLevelExtent || extent > qskMaxLevelExtent )
+            continue;
+
+        const auto size = qskLevelSize( graphic, textureSize, extent );
+
+        if ( levelHash == m_hash && size == m_cachedSize )
+            break; // already displayed
+
+        if ( const auto textureId = QskTextureCache::acquireTexture( levelHash, size ) )
+        {
+            replaceTexture( window, levelHash, size,
+                textureId, QRect(), true, rect, mirrored );
+
+            break;
+        }
+    }
+
+    auto& job = m_pending->levelJob;
+
+    if ( !( levelHash == m_hash && levelSize == m_cachedSize ) )
+    {
+        if ( job.isNull() || job->hash != levelHash || job->size != levelSize )
+            job = qskJobTable->job( levelHash, levelSize, graphic, colorFilter );
+
+        job->addWindow( window );
+    }
+}
+
+bool QskGraphicNode::isPending() const
+{
+    return m_pending && !m_pending->job.isNull();
+}
+
+bool QskGraphicNode::isLevelPending() const
+{
+    return m_pending && !m_pending->levelJob.isNull();
+}
+
+void QskGraphicNode::preprocess()
+{
+    if ( m_pending == nullptr )
+        return;
+
+    if ( isLevelPending() && m_pending->levelJob->isFinished() )
+        uploadLevel();
+
+    if ( !isPending() || !m_pending->job->isFinished() )
+        return;
+
+    const auto job = m_pending->job;
+    m_pending->job.reset();
+
+    /*
+        We can't reset the UsePreprocess flag as we are called
+        from preprocess(). But the following calls are cheap
+        without having a job.
+     */
+
+    bool isCached = true;
+    QRect atlasRect;
+
+    // another node might have uploaded the same image in the meantime
+    auto textureId = QskTextureCache::acquireTexture( job->hash, job->size, &atlasRect );
+    if ( textureId == 0 )
+    {
+        textureId = qskUploadImage( job->hash, job->size,
+            job->image(), atlasRect, isCached );
     }
 
-    auto textureId = QskTextureNode::textureId();
+    replaceTexture( m_pending->window, job->hash, job->size,
+        textureId, atlasRect, isCached, m_pending->rect, m_pending->mirrored );
+}
+
+void QskGraphicNode::uploadLevel()
+{
+    const auto job = m_pending->levelJob;
+    m_pending->levelJob.reset();
+
+    // displaying the level makes only sense until the exact texture is available
+    const bool isDisplayed = isPending() && !m_pending->job->isFinished()
+        && ( job->hash == qskLevelHash( m_pending->job->hash ) );
 
-    if ( isTextureDirty )
+    bool isCached = true;
+
+    auto textureId = QskTextureCache::acquireTexture( job->hash, job->size );
+    if ( textureId == 0 )
+    {
+        textureId = QskTextureRenderer::createTextureFromImage( job->image(), true );
+        isCached = QskTextureCache::insertTexture( job->hash, job->size, textureId );
+    }
+
+    if ( isDisplayed )
+    {
+        replaceTexture( m_pending->window, job->hash, job->size,
+            textureId, QRect(), isCached, m_pending->rect, m_pending->mirrored );
+    }
+    else
     {
-        textureId = QskTextureRenderer::createTextureFromGraphic(
-            renderMode, textureSize, graphic, colorFilter, Qt::IgnoreAspectRatio );
+        // only kept by the cache for the following updates
+        if ( isCached )
+            QskTextureCache::releaseTexture( job->hash, job->size );
+        else
+            qskDeleteTexture( textureId );
     }
+}
+
+void QskGraphicNode::replaceTexture( QQuickWindow* window,
+    uint hash, const QSize& textureSize, uint textureId,
+    const QRect& atlasRect, bool isCached,
+    const QRectF& rect, Qt::Orientations mirrored )
+{
+    if ( m_cachedSize.isValid() )
+        QskTextureCache::releaseTexture( m_hash, m_cachedSize );
+
+    m_hash = hash;
+    m_cachedSize = isCached ? textureSize : QSize();
+
+    QRectF textureRect( 0.0, 0.0, 1.0, 1.0 );
+    if ( atlasRect.isValid() )
+        textureRect = QskTextureAtlas::textureRect( atlasRect );
 
-    QskTextureNode::setTexture( window, rect, textureId, mirrored );
+    // the ownership flag has to be valid for the texture being replaced
+    QskTextureNode::setTexture( window, rect, textureId, textureRect, mirrored );
+    setOwnsTexture( !isCached );
 }
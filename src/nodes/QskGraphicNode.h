@@ -9,6 +9,9 @@
 #include "QskTextureRenderer.h"
 #include "QskTextureNode.h"
 
+#include <qsize.h>
+#include <memory>
+
 class QskGraphic;
 class QskColorFilter;
 class QQuickWindow;
@@ -24,11 +27,44 @@ class QSK_EXPORT QskGraphicNode : public QskTextureNode
         QskTextureRenderer::RenderMode, const QRectF&,
         Qt::Orientations mirrored = Qt::Orientations() );
 
+    // true, while waiting for a texture being rendered in a worker thread
+    bool isPending() const;
+
+    /*
+        When rendering asynchronously the node displays the nearest
+        texture of a power of two size - scaled by the GPU - until the
+        texture for the exact size is available. These levels are shared by
+        QskTextureCache, so that resizing/zooming animations do not
+        need to paint for each frame. Missing levels are painted in
+        a worker thread like the exact textures.
+     */
+    void setRasterLevels( bool );
+    bool hasRasterLevels() const;
+
+    void preprocess() override;
+
   private:
     void setTexture( QQuickWindow*,
         const QRectF&, uint id, Qt::Orientations ) = delete;
 
+    void replaceTexture( QQuickWindow*, uint hash, const QSize&,
+        uint textureId, const QRect& atlasRect, bool isCached,
+        const QRectF&, Qt::Orientations );
+
+    void setLevelTexture( QQuickWindow*, uint hash, const QSize& textureSize,
+        const QskGraphic&, const QskColorFilter&, const QRectF&, Qt::Orientations );
+
+    void uploadLevel();
+    bool isLevelPending() const;
+
     uint m_hash;
+    bool m_rasterLevels;
+
+    // size of the texture, when being shared by QskTextureCache
+    QSize m_cachedSize;
+
+    class PendingData;
+    std::unique_ptr< PendingData > m_pending;
 };
 
 #endif
@@ -0,0 +1,164 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskMergedBoxNode.h"
+#include "QskBoxRenderer.h"
+#include "QskNodeStatistics.h"
+
+#include <qglobalstatic.h>
+#include <qsgvertexcolormaterial.h>
+#include <qvarlengtharray.h>
+
+#include <cstring>
+
+// one material for all merged nodes, so that they can be batched
+Q_GLOBAL_STATIC( QSGVertexColorMaterial, qskMaterialVertex )
+
+static inline uint qskBoxHash( const QskMergedBoxNode::Box& box )
+{
+    uint hash = 16000;
+
+    hash = qHashBits( &box.rect, sizeof( box.rect ), hash );
+    hash = box.shape.hash( hash );
+    hash = box.borderMetrics.hash( hash );
+    hash = box.borderColors.hash( hash );
+
+    return box.gradient.hash( hash );
+}
+
+static void qskRenderBox( const QskMergedBoxNode::Box& box,
+    QVector< QSGGeometry::ColoredPoint2D >& vertices )
+{
+    vertices.clear();
+
+    if ( box.rect.isEmpty() )
+        return;
+
+    const bool hasFill = box.gradient.isValid();
+    const bool hasBorder = !box.borderMetrics.isNull() && box.borderColors.isVisible();
+
+    if ( !hasFill && !hasBorder )
+        return;
+
+    QSGGeometry geometry( QSGGeometry::defaultAttributes_ColoredPoint2D(), 0 );
+
+    QskBoxRenderer renderer;
+    renderer.renderBox( box.rect, box.shape, box.borderMetrics,
+        box.borderColors, box.gradient, geometry );
+
+    const int count = geometry.vertexCount();
+    if ( count == 0 )
+        return;
+
+    const auto points = geometry.vertexDataAsColoredPoint2D();
+
+    /*
+        The strips of the boxes are joined by repeating the first and
+        the last vertex of each box, what results in degenerate triangles
+        only. As the joints are part of the range of each box we can
+        update a box without touching its neighbours.
+     */
+
+    vertices.resize( count + 2 );
+
+    auto to = vertices.data();
+
+    to[ 0 ] = points[ 0 ];
+    std::memcpy( to + 1, points, count * sizeof( points[ 0 ] ) );
+    to[ count + 1 ] = points[ count - 1 ];
+
+    QskNodeStatistics::increment( QskNodeStatistics::GeometryUpdates );
+}
+
+QskMergedBoxNode::QskMergedBoxNode()
+    : m_geometry( QSGGeometry::defaultAttributes_ColoredPoint2D(), 0 )
+{
+    m_geometry.setDrawingMode( QSGGeometry::DrawTriangleStrip );
+
+    setMaterial( qskMaterialVertex );
+    setGeometry( &m_geometry );
+}
+
+QskMergedBoxNode::~QskMergedBoxNode()
+{
+}
+
+int QskMergedBoxNode::boxCount() const
+{
+    return m_ranges.count();
+}
+
+void QskMergedBoxNode::setBoxes( const QVector< Box >& boxes )
+{
+    bool rebuild = ( boxes.count() != m_ranges.count() );
+
+    if ( rebuild )
+        m_ranges.resize( boxes.count() );
+
+    QVarLengthArray< bool, 8 > modified( boxes.count() );
+
+    for ( int i = 0; i < boxes.count(); i++ )
+    {
+        auto& range = m_ranges[ i ];
+
+        const auto hash = qskBoxHash( boxes[ i ] );
+
+        modified[ i ] = ( hash != range.hash );
+        if ( !modified[ i ] )
+            continue;
+
+        const int oldCount = range.vertices.count();
+
+        qskRenderBox( boxes[ i ], range.vertices );
+        range.hash = hash;
+
+        if ( range.vertices.count() != oldCount )
+            rebuild = true;
+    }
+
+    if ( rebuild )
+    {
+        int count = 0;
+        for ( const auto& range : qskAsConst( m_ranges ) )
+            count += range.vertices.count();
+
+        m_geometry.allocate( count );
+
+        auto to = m_geometry.vertexDataAsColoredPoint2D();
+
+        for ( const auto& range : qskAsConst( m_ranges ) )
+        {
+            const int n = range.vertices.count();
+
+            std::memcpy( to, range.vertices.constData(), n * sizeof( *to ) );
+            to += n;
+        }
+
+        markDirty( QSGNode::DirtyGeometry );
+        return;
+    }
+
+    bool isDirty = false;
+
+    auto to = m_geometry.vertexDataAsColoredPoint2D();
+
+    for ( int i = 0; i < m_ranges.count(); i++ )
+    {
+        const auto& range = m_ranges[ i ];
+        const int n = range.vertices.count();
+
+        if ( modified[ i ] )
+        {
+            // the vertex count is unchanged: only rewriting the range of the box
+            std::memcpy( to, range.vertices.constData(), n * sizeof( *to ) );
+            isDirty = true;
+        }
+
+        to += n;
+    }
+
+    if ( isDirty )
+        markDirty( QSGNode::DirtyGeometry );
+}
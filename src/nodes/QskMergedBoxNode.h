@@ -0,0 +1,59 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_MERGED_BOX_NODE_H
+#define QSK_MERGED_BOX_NODE_H
+
+#include "QskBoxBorderColors.h"
+#include "QskBoxBorderMetrics.h"
+#include "QskBoxShapeMetrics.h"
+#include "QskGradient.h"
+
+#include <qsgnode.h>
+#include <qvector.h>
+
+/*
+    QskMergedBoxNode displays several boxes - f.e. all boxes of a control -
+    with one geometry using vertex colors. Boxes are drawn in the order
+    of the list, so they need to be next to each other in the stacking
+    order of the nodes.
+
+    Each box is rendered again only when its data has changed. As long
+    as the number of vertices does not change only its range
+    of the geometry is updated.
+ */
+class QSK_EXPORT QskMergedBoxNode : public QSGGeometryNode
+{
+  public:
+    class Box
+    {
+      public:
+        QRectF rect;
+
+        QskBoxShapeMetrics shape;
+        QskBoxBorderMetrics borderMetrics;
+        QskBoxBorderColors borderColors;
+        QskGradient gradient;
+    };
+
+    QskMergedBoxNode();
+    ~QskMergedBoxNode() override;
+
+    void setBoxes( const QVector< Box >& );
+    int boxCount() const;
+
+  private:
+    class Range
+    {
+      public:
+        uint hash = 0;
+        QVector< QSGGeometry::ColoredPoint2D > vertices;
+    };
+
+    QVector< Range > m_ranges;
+    QSGGeometry m_geometry;
+};
+
+#endif
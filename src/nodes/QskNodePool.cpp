@@ -0,0 +1,211 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskNodePool.h"
+
+#include <qatomic.h>
+#include <qglobalstatic.h>
+#include <qhash.h>
+#include <qmatrix4x4.h>
+#include <qmutex.h>
+#include <qquickwindow.h>
+#include <qvector.h>
+
+static QAtomicInt qskMaxNodeCount( 100 );
+
+static inline bool qskIsPlainNode( const QSGNode* node )
+{
+    const auto& type = typeid( *node );
+    return ( type == typeid( QSGNode ) ) || ( type == typeid( QSGTransformNode ) );
+}
+
+namespace
+{
+    class Pool
+    {
+      public:
+        const std::type_info* type;
+        QVector< QSGNode* > nodes;
+    };
+
+    class PoolMap
+    {
+      public:
+        /*
+            Nodes, that are left when the application terminates, are
+            leaked as the resources they refer to might be gone already.
+            Usually the pools have been cleared, when the scene graph
+            was invalidated.
+         */
+
+        QSGNode* take( QQuickWindow* window, const std::type_info& type )
+        {
+            QMutexLocker locker( &m_mutex );
+
+            auto it = m_windows.find( window );
+            if ( it == m_windows.end() )
+            {
+                /*
+                    The entry of the window is kept until the window is
+                    destroyed, so that we connect only once - even when
+                    the scene graph gets invalidated several times.
+                 */
+                QObject::connect( window, &QQuickWindow::sceneGraphInvalidated,
+                    window, [ this, window ] { clear( window, false ); },
+                    Qt::DirectConnection );
+
+                QObject::connect( window, &QObject::destroyed,
+                    window, [ this, window ] { clear( window, true ); },
+                    Qt::DirectConnection );
+
+                it = m_windows.insert( window, QVector< Pool >() );
+            }
+
+            auto& pools = it.value();
+
+            for ( auto& pool : pools )
+            {
+                if ( *pool.type == type )
+                {
+                    if ( pool.nodes.isEmpty() )
+                        return nullptr;
+
+                    return pool.nodes.takeLast();
+                }
+            }
+
+            // from now on nodes of this type are accepted
+            pools += Pool { &type, QVector< QSGNode* >() };
+
+            return nullptr;
+        }
+
+        bool insert( QQuickWindow* window, QSGNode* node )
+        {
+            QMutexLocker locker( &m_mutex );
+
+            auto it = m_windows.find( window );
+            if ( it == m_windows.end() )
+                return false;
+
+            const auto& type = typeid( *node );
+
+            for ( auto& pool : it.value() )
+            {
+                if ( *pool.type == type )
+                {
+                    if ( pool.nodes.count() >= qskMaxNodeCount.loadAcquire() )
+                        return false;
+
+                    pool.nodes += node;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void clear( QQuickWindow* window, bool remove )
+        {
+            QVector< QSGNode* > nodes;
+
+            {
+                QMutexLocker locker( &m_mutex );
+
+                auto it = m_windows.find( window );
+                if ( it == m_windows.end() )
+                    return;
+
+                for ( auto& pool : it.value() )
+                {
+                    nodes += pool.nodes;
+                    pool.nodes.clear();
+                }
+
+                if ( remove )
+                    m_windows.erase( it );
+            }
+
+            qDeleteAll( nodes );
+        }
+
+      private:
+        QMutex m_mutex;
+        QHash< QQuickWindow*, QVector< Pool > > m_windows;
+    };
+}
+
+Q_GLOBAL_STATIC( PoolMap, qskPoolMap )
+
+QSGNode* QskNodePool::takeNode( QQuickWindow* window, const std::type_info& type )
+{
+    if ( window == nullptr || qskMaxNodeCount.loadAcquire() <= 0 )
+        return nullptr;
+
+    if ( qskPoolMap.isDestroyed() )
+        return nullptr;
+
+    return qskPoolMap->take( window, type );
+}
+
+void QskNodePool::releaseNode( QQuickWindow* window, QSGNode* node )
+{
+    if ( node == nullptr )
+        return;
+
+    if ( auto parent = node->parent() )
+        parent->removeChildNode( node );
+
+    if ( !( node->flags() & QSGNode::OwnedByParent ) )
+        return;
+
+    // the node role of QskSGNode has to be set by the next owner
+    node->setFlags( QSGNode::Flags( 0xff00 ), false );
+
+    if ( qskIsPlainNode( node ) )
+    {
+        /*
+            Plain nodes are only containers for the nodes of the skinlets,
+            so we can recycle their children as well.
+         */
+        while ( auto child = node->firstChild() )
+            releaseNode( window, child );
+
+        if ( node->type() == QSGNode::TransformNodeType )
+        {
+            auto transformNode = static_cast< QSGTransformNode* >( node );
+            if ( !transformNode->matrix().isIdentity() )
+                transformNode->setMatrix( QMatrix4x4() );
+        }
+    }
+
+    if ( window && !qskPoolMap.isDestroyed() )
+    {
+        if ( qskPoolMap->insert( window, node ) )
+            return;
+    }
+
+    delete node;
+}
+
+void QskNodePool::setMaxNodeCount( int count )
+{
+    /*
+        Nodes, that are already in the pool, are not deleted here
+        as we might not be in the scene graph thread.
+     */
+    qskMaxNodeCount.storeRelease( qMax( count, 0 ) );
+}
+
+int QskNodePool::maxNodeCount()
+{
+    return qskMaxNodeCount.loadAcquire();
+}
+
+void QskNodePool::clear( QQuickWindow* window )
+{
+    if ( window && !qskPoolMap.isDestroyed() )
+        qskPoolMap->clear( window, false );
+}
@@ -0,0 +1,68 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_NODE_POOL_H
+#define QSK_NODE_POOL_H
+
+#include "QskGlobal.h"
+
+#include <qsgnode.h>
+#include <typeinfo>
+
+class QQuickWindow;
+
+/*
+    A pool of scene graph nodes, that are not part of the scene graph
+    anymore and can be reused by the skinlets of the same window
+    instead of allocating new ones.
+
+    Nodes are pooled by their dynamic type. Only types, that have been
+    acquired from the pool before, are accepted - all other nodes are
+    simply deleted, when being released.
+
+    Plain QSGNode/QSGTransformNode instances are reset, when being released:
+    their children are released recursively. Nodes of other types keep their
+    subtree and state and are expected to be fully updated by the code
+    acquiring them ( f.e. QskBoxNode::setBoxData ).
+
+    The pool is bound to the scene graph of the window and all nodes are
+    deleted, when it gets invalidated. The functions need to be called
+    from the scene graph thread.
+ */
+namespace QskNodePool
+{
+    template< typename Node >
+    Node* acquireNode( QQuickWindow* );
+
+    /*
+        Removes the node from its parent and passes it to the pool.
+        Nodes, that are not owned by their parent, are removed only.
+     */
+    QSK_EXPORT void releaseNode( QQuickWindow*, QSGNode* );
+
+    /*
+        max. number of unused nodes per type and window,
+        0 disables the pool
+     */
+    QSK_EXPORT void setMaxNodeCount( int );
+    QSK_EXPORT int maxNodeCount();
+
+    // deleting all unused nodes of the window
+    QSK_EXPORT void clear( QQuickWindow* );
+
+    // returns nullptr, when no unused node of the type is available
+    QSK_EXPORT QSGNode* takeNode( QQuickWindow*, const std::type_info& );
+}
+
+template< typename Node >
+inline Node* QskNodePool::acquireNode( QQuickWindow* window )
+{
+    if ( auto node = takeNode( window, typeid( Node ) ) )
+        return static_cast< Node* >( node );
+
+    return new Node();
+}
+
+#endif
@@ -0,0 +1,319 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskNodeStatistics.h"
+
+#include <qatomic.h>
+#include <qbytearray.h>
+#include <qdebug.h>
+#include <qglobalstatic.h>
+#include <qhash.h>
+#include <qjsondocument.h>
+#include <qjsonobject.h>
+#include <qmutex.h>
+#include <qpointer.h>
+#include <qquickwindow.h>
+#include <qvector.h>
+
+static QAtomicInt qskEnabled( 0 );
+
+// the class name of the innermost scope of the current thread
+static thread_local const char* qskCurrentClassName = nullptr;
+
+static const char* qskCounterName( int counter )
+{
+    static const char* names[] =
+    {
+        "nodeUpdates",
+        "geometryUpdates",
+        "textLayouts",
+        "textureUploads"
+    };
+
+    return names[ counter ];
+}
+
+namespace
+{
+    class Counters
+    {
+      public:
+        Counters()
+        {
+            reset();
+        }
+
+        void reset()
+        {
+            for ( int i = 0; i < QskNodeStatistics::CounterCount; i++ )
+                values[ i ] = 0;
+        }
+
+        QJsonObject toJson() const
+        {
+            QJsonObject object;
+
+            for ( int i = 0; i < QskNodeStatistics::CounterCount; i++ )
+                object.insert( QLatin1String( qskCounterName( i ) ), values[ i ] );
+
+            return object;
+        }
+
+        int values[ QskNodeStatistics::CounterCount ];
+    };
+
+    class FrameCounters
+    {
+      public:
+        void increment( QskNodeStatistics::Counter counter )
+        {
+            frame.values[ counter ]++;
+            total.values[ counter ]++;
+        }
+
+        void finishFrame()
+        {
+            for ( int i = 0; i < QskNodeStatistics::CounterCount; i++ )
+            {
+                lastFrame.values[ i ] = frame.values[ i ];
+                maxFrame.values[ i ] = qMax( maxFrame.values[ i ], frame.values[ i ] );
+            }
+
+            frame.reset();
+        }
+
+        void reset()
+        {
+            frame.reset();
+            lastFrame.reset();
+            maxFrame.reset();
+            total.reset();
+        }
+
+        QJsonObject toJson() const
+        {
+            QJsonObject object;
+
+            object.insert( QStringLiteral( "total" ), total.toJson() );
+            object.insert( QStringLiteral( "lastFrame" ), lastFrame.toJson() );
+            object.insert( QStringLiteral( "maxFrame" ), maxFrame.toJson() );
+
+            return object;
+        }
+
+        Counters frame;
+        Counters lastFrame;
+        Counters maxFrame;
+        Counters total;
+    };
+
+    class Statistics
+    {
+      public:
+        void increment( QskNodeStatistics::Counter counter )
+        {
+            QMutexLocker locker( &mutex );
+
+            counters.increment( counter );
+
+            const char* className = qskCurrentClassName;
+            if ( className == nullptr )
+                className = "(unknown)";
+
+            classes[ className ].increment( counter );
+        }
+
+        void finishFrame()
+        {
+            QMutexLocker locker( &mutex );
+
+            frameCount++;
+
+            counters.finishFrame();
+
+            for ( auto& classCounters : classes )
+                classCounters.finishFrame();
+        }
+
+        void reset()
+        {
+            QMutexLocker locker( &mutex );
+
+            frameCount = 0;
+
+            counters.reset();
+            classes.clear();
+        }
+
+        void addWindow( QQuickWindow* window )
+        {
+            QMutexLocker locker( &mutex );
+
+            for ( const auto& w : qskAsConst( windows ) )
+            {
+                if ( w == window )
+                    return;
+            }
+
+            windows += window;
+
+            QObject::connect( window, &QQuickWindow::afterRendering,
+                window, [] { QskNodeStatistics::finishFrame(); },
+                Qt::DirectConnection );
+        }
+
+        QMutex mutex;
+
+        int frameCount = 0;
+
+        FrameCounters counters;
+
+        // class names are static strings from the meta objects
+        QHash< const char*, FrameCounters > classes;
+
+        QVector< QPointer< QQuickWindow > > windows;
+    };
+}
+
+Q_GLOBAL_STATIC( Statistics, qskStatistics )
+
+void QskNodeStatistics::setEnabled( bool on )
+{
+    qskEnabled.storeRelease( on ? 1 : 0 );
+}
+
+bool QskNodeStatistics::isEnabled()
+{
+    return qskEnabled.loadAcquire() != 0;
+}
+
+void QskNodeStatistics::increment( Counter counter )
+{
+    if ( counter < 0 || counter >= CounterCount )
+        return;
+
+    if ( isEnabled() && !qskStatistics.isDestroyed() )
+        qskStatistics->increment( counter );
+}
+
+void QskNodeStatistics::finishFrame()
+{
+    if ( isEnabled() && !qskStatistics.isDestroyed() )
+        qskStatistics->finishFrame();
+}
+
+void QskNodeStatistics::reset()
+{
+    if ( !qskStatistics.isDestroyed() )
+        qskStatistics->reset();
+}
+
+int QskNodeStatistics::frameCount()
+{
+    if ( qskStatistics.isDestroyed() )
+        return 0;
+
+    QMutexLocker locker( &qskStatistics->mutex );
+    return qskStatistics->frameCount;
+}
+
+int QskNodeStatistics::totalValue( Counter counter )
+{
+    if ( counter < 0 || counter >= CounterCount || qskStatistics.isDestroyed() )
+        return 0;
+
+    QMutexLocker locker( &qskStatistics->mutex );
+    return qskStatistics->counters.total.values[ counter ];
+}
+
+int QskNodeStatistics::lastFrameValue( Counter counter )
+{
+    if ( counter < 0 || counter >= CounterCount || qskStatistics.isDestroyed() )
+        return 0;
+
+    QMutexLocker locker( &qskStatistics->mutex );
+    return qskStatistics->counters.lastFrame.values[ counter ];
+}
+
+int QskNodeStatistics::maxFrameValue( Counter counter )
+{
+    if ( counter < 0 || counter >= CounterCount || qskStatistics.isDestroyed() )
+        return 0;
+
+    QMutexLocker locker( &qskStatistics->mutex );
+    return qskStatistics->counters.maxFrame.values[ counter ];
+}
+
+int QskNodeStatistics::lastFrameValue( const char* className, Counter counter )
+{
+    if ( counter < 0 || counter >= CounterCount || qskStatistics.isDestroyed() )
+        return 0;
+
+    QMutexLocker locker( &qskStatistics->mutex );
+
+    for ( auto it = qskStatistics->classes.constBegin();
+        it != qskStatistics->classes.constEnd(); ++it )
+    {
+        if ( qstrcmp( it.key(), className ) == 0 )
+            return it.value().lastFrame.values[ counter ];
+    }
+
+    return 0;
+}
+
+QByteArray QskNodeStatistics::toJson()
+{
+    if ( qskStatistics.isDestroyed() )
+        return QByteArray();
+
+    auto statistics = qskStatistics();
+
+    QJsonObject object;
+
+    {
+        QMutexLocker locker( &statistics->mutex );
+
+        object.insert( QStringLiteral( "frames" ), statistics->frameCount );
+        const auto counters = statistics->counters.toJson();
+        for ( auto it = counters.constBegin(); it != counters.constEnd(); ++it )
+            object.insert( it.key(), it.value() );
+
+        QJsonObject classes;
+
+        for ( auto it = statistics->classes.constBegin();
+            it != statistics->classes.constEnd(); ++it )
+        {
+            classes.insert( QLatin1String( it.key() ), it.value().toJson() );
+        }
+
+        object.insert( QStringLiteral( "classes" ), classes );
+    }
+
+    return QJsonDocument( object ).toJson();
+}
+
+void QskNodeStatistics::dump()
+{
+    qDebug().noquote() << QString::fromUtf8( toJson() );
+}
+
+QskNodeStatistics::Scope::Scope( QQuickWindow* window, const char* className )
+    : m_outerClassName( qskCurrentClassName )
+    , m_active( isEnabled() )
+{
+    if ( m_active )
+    {
+        qskCurrentClassName = className;
+
+        if ( window && !qskStatistics.isDestroyed() )
+            qskStatistics->addWindow( window );
+    }
+}
+
+QskNodeStatistics::Scope::~Scope()
+{
+    if ( m_active )
+        qskCurrentClassName = m_outerClassName;
+}
@@ -0,0 +1,72 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_NODE_STATISTICS_H
+#define QSK_NODE_STATISTICS_H
+
+#include "QskGlobal.h"
+
+class QQuickWindow;
+class QByteArray;
+
+/*
+    Opt-in counters for the expensive operations, that happen when
+    updating the scene graph nodes. They are counted in total, per frame
+    and per class of the control being updated, so that it is possible
+    to find out which control is rebuilding its nodes over and over.
+
+    A frame is finished, when one of the windows, that had
+    updated nodes, has been rendered. For applications with several
+    windows the frame values are the sum of all windows.
+ */
+namespace QskNodeStatistics
+{
+    enum Counter
+    {
+        NodeUpdates,     // QskSkinlet::updateNode
+        GeometryUpdates, // QskBoxNode::setBoxData with modified data
+        TextLayouts,     // QskTextNode::setTextData with modified data
+        TextureUploads,  // textures, atlas, gradients and shadows
+
+        CounterCount
+    };
+
+    QSK_EXPORT void setEnabled( bool );
+    QSK_EXPORT bool isEnabled();
+
+    QSK_EXPORT void increment( Counter );
+
+    QSK_EXPORT void finishFrame();
+    QSK_EXPORT void reset();
+
+    QSK_EXPORT int frameCount();
+
+    QSK_EXPORT int totalValue( Counter );
+    QSK_EXPORT int lastFrameValue( Counter );
+    QSK_EXPORT int maxFrameValue( Counter );
+
+    // the value of the last frame for the controls of a class
+    QSK_EXPORT int lastFrameValue( const char* className, Counter );
+
+    QSK_EXPORT QByteArray toJson();
+    QSK_EXPORT void dump();
+
+    /*
+        All counters incremented in the lifetime of a Scope are
+        assigned to its class name. Scopes can be nested.
+     */
+    class QSK_EXPORT Scope
+    {
+      public:
+        Scope( QQuickWindow*, const char* className );
+        ~Scope();
+
+      private:
+        const char* m_outerClassName;
+        bool m_active;
+    };
+}
+
+#endif
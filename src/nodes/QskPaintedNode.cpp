@@ -4,8 +4,12 @@
  *****************************************************************************/
 
 #include "QskPaintedNode.h"
+#include "QskTextureAtlas.h"
 #include "QskTextureRenderer.h"
 
+#include <qimage.h>
+#include <qpainter.h>
+
 class QskPaintedNode::PaintHelper : public QskTextureRenderer::PaintHelper
 {
   public:
@@ -24,25 +28,35 @@ class QskPaintedNode::PaintHelper : public QskTextureRenderer::PaintHelper
 };
 
 QskPaintedNode::QskPaintedNode()
+    : m_hash( 0 )
 {
 }
 
 QskPaintedNode::~QskPaintedNode()
 {
+    if ( m_atlasRect.isValid() )
+        QskTextureAtlas::releaseImage( textureId(), m_atlasRect );
+}
+
+QRegion QskPaintedNode::dirtyRegion( const QSize& )
+{
+    return QRegion();
 }
 
 void QskPaintedNode::update( QQuickWindow* window,
     QskTextureRenderer::RenderMode renderMode, const QRect& rect )
 {
-    bool isTextureDirty = isNull();
+    bool isResized = isNull();
 
-    if ( !isTextureDirty )
+    if ( !isResized )
     {
         const auto oldRect = QskTextureNode::rect();
-        isTextureDirty = ( rect.width() != static_cast< int >( oldRect.width() ) ) ||
+        isResized = ( rect.width() != static_cast< int >( oldRect.width() ) ) ||
             ( rect.height() != static_cast< int >( oldRect.height() ) );
     }
 
+    bool isTextureDirty = isResized;
+
     const auto newHash = hash();
     if ( ( newHash == 0 ) || ( newHash != m_hash ) )
     {
@@ -50,14 +64,87 @@ void QskPaintedNode::update( QQuickWindow* window,
         isTextureDirty = true;
     }
 
-    auto textureId = QskTextureNode::textureId();
+    if ( !isTextureDirty || ( !isResized && updatePartially( rect.size() ) ) )
+    {
+        QskTextureNode::setTexture( window, rect,
+            QskTextureNode::textureId(), textureRect() );
+
+        return;
+    }
 
-    if ( isTextureDirty )
+    PaintHelper helper( this );
+
+    const bool isRaster = ( renderMode == QskTextureRenderer::Raster )
+        || ( renderMode == QskTextureRenderer::AsyncRaster );
+
+    QImage image;
+    if ( isRaster || QskTextureAtlas::isCandidate( rect.size() ) )
+        image = QskTextureRenderer::createImage( rect.size(), &helper );
+
+    QRect atlasRect;
+    uint textureId = QskTextureAtlas::insertImage( image, &atlasRect );
+
+    if ( textureId == 0 )
     {
-        PaintHelper helper( this );
-        textureId = QskTextureRenderer::createTexture(
-            renderMode, rect.size(), &helper );
+        if ( image.isNull() )
+        {
+            textureId = QskTextureRenderer::createTexture(
+                renderMode, rect.size(), &helper );
+        }
+        else
+        {
+            textureId = QskTextureRenderer::createTextureFromImage( image );
+        }
     }
 
-    QskTextureNode::setTexture( window, rect, textureId );
+    m_image = isRaster ? image : QImage();
+
+    if ( m_atlasRect.isValid() )
+        QskTextureAtlas::releaseImage( QskTextureNode::textureId(), m_atlasRect );
+
+    m_atlasRect = atlasRect;
+
+    QRectF textureRect( 0.0, 0.0, 1.0, 1.0 );
+    if ( atlasRect.isValid() )
+        textureRect = QskTextureAtlas::textureRect( atlasRect );
+
+    // the ownership flag has to be valid for the texture being replaced
+    QskTextureNode::setTexture( window, rect, textureId, textureRect );
+    setOwnsTexture( !atlasRect.isValid() );
+}
+
+bool QskPaintedNode::updatePartially( const QSize& size )
+{
+    if ( m_image.size() != size )
+        return false;
+
+    const auto region = dirtyRegion( size ) & m_image.rect();
+    if ( region.isEmpty() )
+        return false;
+
+    {
+        QPainter painter( &m_image );
+        painter.setClipRegion( region );
+
+        painter.setCompositionMode( QPainter::CompositionMode_Source );
+        painter.fillRect( m_image.rect(), Qt::transparent );
+        painter.setCompositionMode( QPainter::CompositionMode_SourceOver );
+
+        paint( &painter, size );
+    }
+
+    // for the atlas we have to update our part of the shared texture
+    const auto pos = m_atlasRect.isValid() ? m_atlasRect.topLeft() : QPoint();
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 8, 0 )
+    for ( const auto& rect : region )
+        QskTextureRenderer::updateTextureFromImage( textureId(), m_image, rect, pos );
+#else
+    for ( const auto& rect : region.rects() )
+        QskTextureRenderer::updateTextureFromImage( textureId(), m_image, rect, pos );
+#endif
+
+    markDirty( QSGNode::DirtyMaterial );
+
+    return true;
 }
@@ -9,6 +9,10 @@
 #include "QskTextureNode.h"
 #include "QskTextureRenderer.h"
 
+#include <qimage.h>
+#include <qrect.h>
+#include <qregion.h>
+
 class QSK_EXPORT QskPaintedNode : public QskTextureNode
 {
   public:
@@ -24,13 +28,32 @@ class QSK_EXPORT QskPaintedNode : public QskTextureNode
     // a hash value of '0' always results in repainting
     virtual uint hash() = 0;
 
+    /*
+        When the hash value has changed, but the size has not, only
+        the region returned here is repainted and uploaded. The content
+        outside of it is taken from the previous update.
+
+        This is supported for the raster render modes only, where the
+        node keeps a copy of its image. The default implementation returns
+        an empty region, what results in repainting everything.
+     */
+    virtual QRegion dirtyRegion( const QSize& );
+
   private:
     class PaintHelper;
 
     void setTexture( QQuickWindow*,
         const QRectF&, uint id, Qt::Orientations ) = delete;
 
+    bool updatePartially( const QSize& );
+
     uint m_hash;
+
+    // position inside of QskTextureAtlas
+    QRect m_atlasRect;
+
+    // the content of the texture, when painting with raster
+    QImage m_image;
 };
 
 #endif
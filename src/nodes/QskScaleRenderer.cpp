@@ -8,7 +8,6 @@
 #include "QskSGNode.h"
 #include "QskTickmarksNode.h"
 #include "QskTextNode.h"
-#include "QskGraphicNode.h"
 #include "QskTextOptions.h"
 #include "QskGraphic.h"
 #include "QskControl.h"
@@ -17,10 +16,46 @@
 #include <qstring.h>
 #include <qfontmetrics.h>
 
-static QSGNode* qskRemoveTraillingNodes( QSGNode* node, QSGNode* childNode )
+namespace
 {
-    QskSGNode::removeAllChildNodesFrom( node, childNode );
-    return nullptr;
+    enum LabelNodeRole
+    {
+        TextNode = 1,
+        GraphicNode = 2
+    };
+
+    /*
+        Label nodes remember the value of their tick, so that they
+        can be reused, when the tickmarks are shifted. Then only
+        the position of the node has to be updated.
+     */
+    class TextLabelNode final : public QskTextNode
+    {
+      public:
+        qreal tick = 0.0;
+    };
+
+    // the child is a node returned from QskSkinlet::updateGraphicNode
+    class GraphicLabelNode final : public QSGNode
+    {
+      public:
+        qreal tick = 0.0;
+    };
+}
+
+static inline qreal qskLabelTick( const QSGNode* node )
+{
+    if ( QskSGNode::nodeRole( node ) == TextNode )
+        return static_cast< const TextLabelNode* >( node )->tick;
+
+    return static_cast< const GraphicLabelNode* >( node )->tick;
+}
+
+static inline void qskDeleteLabelNode( QSGNode* parentNode, QSGNode* node )
+{
+    parentNode->removeChildNode( node );
+    if ( node->flags() & QSGNode::OwnedByParent )
+        delete node;
 }
 
 static inline void qskInsertRemoveChild( QSGNode* parentNode,
@@ -72,7 +107,11 @@ void QskScaleRenderer::setTickWidth( qreal width )
 
 void QskScaleRenderer::setFont( const QFont& font )
 {
-    m_font = font;
+    if ( font != m_font )
+    {
+        m_font = font;
+        m_textWidths.clear();
+    }
 }
 
 void QskScaleRenderer::setTextColors( const QskTextColors& textColors )
@@ -160,33 +199,30 @@ QSGNode* QskScaleRenderer::updateLabelsNode(
     if( node == nullptr )
         node = new QSGNode;
 
+    QHash< qreal, QSGNode* > oldNodes;
+    for ( auto child = node->firstChild(); child; child = child->nextSibling() )
+        oldNodes.insert( qskLabelTick( child ), child );
+
     const QFontMetricsF fm( m_font );
 
     const qreal length = ( m_orientation == Qt::Horizontal )
         ? tickmarksRect.width() : tickmarksRect.height();
     const qreal ratio = length / m_boundaries.width();
 
-    auto nextNode = node->firstChild();
-
     QRectF labelRect;
+    QSGNode* labelNode = nullptr;
 
     for ( auto tick : ticks )
     {
-        enum LabelNodeRole
-        {
-            TextNode = 1,
-            GraphicNode = 2
-        };
-
-        const auto label = labelAt( tick );
-        if ( label.isNull() )
+        const auto label = this->label( tick );
+        if ( label.value.isNull() )
             continue;
 
         const qreal tickPos = ratio * ( tick - m_boundaries.lowerBound() );
 
-        if ( label.canConvert< QString >() )
+        if ( label.value.canConvert< QString >() )
         {
-            auto text = label.toString();
+            const auto text = label.value.toString();
             if ( text.isEmpty() )
                 continue;
 
@@ -195,7 +231,7 @@ QSGNode* QskScaleRenderer::updateLabelsNode(
 
             if( m_orientation == Qt::Horizontal )
             {
-                const auto w = qskHorizontalAdvance( fm, text );
+                const auto w = label.size.width();
 
                 auto pos = tickmarksRect.x() + tickPos - 0.5 * w;
                 pos = qBound( labelsRect.left(), pos, labelsRect.right() - w );
@@ -206,7 +242,7 @@ QSGNode* QskScaleRenderer::updateLabelsNode(
             }
             else
             {
-                const auto h = fm.height();
+                const auto h = label.size.height();
 
                 auto pos = tickmarksRect.bottom() - ( tickPos + 0.5 * h );
 
@@ -224,56 +260,51 @@ QSGNode* QskScaleRenderer::updateLabelsNode(
                 alignment = Qt::AlignRight;
             }
 
-            if ( nextNode && QskSGNode::nodeRole( nextNode ) != TextNode )
-            {
-                nextNode = qskRemoveTraillingNodes( node, nextNode );
-            }
-
             if ( !labelRect.isEmpty() && labelRect.intersects( r ) )
             {
+                // overlapping labels are hidden, but the last one wins
+
                 if ( tick != ticks.last() )
-                {
-                    text = QString();
-                }
-                else
-                {
-                    if ( auto obsoleteNode = nextNode
-                        ? nextNode->previousSibling() : node->lastChild() )
-                    {
-                        node->removeChildNode( obsoleteNode );
-                        if ( obsoleteNode->flags() & QSGNode::OwnedByParent )
-                            delete obsoleteNode;
-                    }
-
-                    labelRect = r;
-                }
+                    continue;
+
+                if ( labelNode )
+                    qskDeleteLabelNode( node, labelNode );
             }
-            else
+
+            labelRect = r;
+
+            auto textNode = oldNodes.take( tick );
+            if ( textNode && QskSGNode::nodeRole( textNode ) != TextNode )
             {
-                labelRect = r;
+                qskDeleteLabelNode( node, textNode );
+                textNode = nullptr;
             }
 
-            if ( nextNode == nullptr )
+            if ( textNode == nullptr )
             {
-                nextNode = new QskTextNode;
-                QskSGNode::setNodeRole( nextNode, TextNode );
-                node->appendChildNode( nextNode );
+                auto newNode = new TextLabelNode;
+                newNode->tick = tick;
+
+                QskSGNode::setNodeRole( newNode, TextNode );
+                node->appendChildNode( newNode );
+
+                textNode = newNode;
             }
 
-            auto textNode = static_cast< QskTextNode* >( nextNode );
-            textNode->setTextData( skinnable->owningControl(), text, r, m_font,
+            static_cast< QskTextNode* >( textNode )->setTextData(
+                skinnable->owningControl(), text, r, m_font,
                 QskTextOptions(), m_textColors, alignment, Qsk::Normal );
 
-            nextNode = nextNode->nextSibling();
+            labelNode = textNode;
         }
-        else if ( label.canConvert< QskGraphic >() )
+        else if ( label.value.canConvert< QskGraphic >() )
         {
-            const auto graphic = label.value< QskGraphic >();
+            const auto graphic = label.value.value< QskGraphic >();
             if ( graphic.isNull() )
                 continue;
 
-            const auto h = fm.height();
-            const auto w = graphic.widthForHeight( h );
+            const auto w = label.size.width();
+            const auto h = label.size.height();
 
             Qt::Alignment alignment;
 
@@ -294,29 +325,45 @@ QSGNode* QskScaleRenderer::updateLabelsNode(
                 alignment = Qt::AlignRight | Qt::AlignVCenter;
             }
 
-            if ( nextNode && QskSGNode::nodeRole( nextNode ) != GraphicNode )
+            auto graphicLabelNode = oldNodes.take( tick );
+            if ( graphicLabelNode && QskSGNode::nodeRole( graphicLabelNode ) != GraphicNode )
             {
-                nextNode = qskRemoveTraillingNodes( node, nextNode );
+                qskDeleteLabelNode( node, graphicLabelNode );
+                graphicLabelNode = nullptr;
             }
 
-            if ( nextNode == nullptr )
+            if ( graphicLabelNode == nullptr )
             {
-                nextNode = new QskGraphicNode;
-                QskSGNode::setNodeRole( nextNode, GraphicNode );
-                node->appendChildNode( nextNode );
+                auto newNode = new GraphicLabelNode;
+                newNode->tick = tick;
+
+                QskSGNode::setNodeRole( newNode, GraphicNode );
+                node->appendChildNode( newNode );
+
+                graphicLabelNode = newNode;
             }
 
-            auto graphicNode = static_cast< QskGraphicNode* >( nextNode );
+            auto oldGraphicNode = graphicLabelNode->firstChild();
 
-            QskSkinlet::updateGraphicNode(
-                skinnable->owningControl(), graphicNode,
+            auto graphicNode = QskSkinlet::updateGraphicNode(
+                skinnable->owningControl(), oldGraphicNode,
                 graphic, m_colorFilter, labelRect, alignment );
 
-            nextNode = nextNode->nextSibling();
+            if ( graphicNode != oldGraphicNode )
+            {
+                if ( oldGraphicNode )
+                    qskDeleteLabelNode( graphicLabelNode, oldGraphicNode );
+
+                if ( graphicNode )
+                    graphicLabelNode->appendChildNode( graphicNode );
+            }
+
+            labelNode = graphicLabelNode;
         }
     }
 
-    qskRemoveTraillingNodes( node, nextNode );
+    for ( auto it = oldNodes.constBegin(); it != oldNodes.constEnd(); ++it )
+        qskDeleteLabelNode( node, it.value() );
 
     return node;
 }
@@ -339,27 +386,58 @@ QSizeF QskScaleRenderer::boundingLabelSize() const
 
     for ( auto tick : ticks )
     {
-        qreal w = 0.0;
+        const auto label = this->label( tick );
+        maxWidth = qMax( label.size.width(), maxWidth );
+    }
 
-        const auto label = labelAt( tick );
-        if ( label.isNull() )
-            continue;
+    return QSizeF( maxWidth, h );
+}
+
+QskScaleRenderer::Label QskScaleRenderer::label( qreal tick ) const
+{
+    /*
+        labelAt() is called for each update, as we can't know, when
+        the result of an overloaded implementation changes.
+     */
+    Label label;
+    label.value = labelAt( tick );
+
+    if ( !label.value.isNull() )
+    {
+        const QFontMetricsF fm( m_font );
+        const qreal h = fm.height();
 
-        if ( label.canConvert< QString >() )
+        if ( label.value.canConvert< QString >() )
         {
-            w = qskHorizontalAdvance( fm, label.toString() );
+            label.size = QSizeF( textWidth( label.value.toString() ), h );
         }
-        else if ( label.canConvert< QskGraphic >() )
+        else if ( label.value.canConvert< QskGraphic >() )
         {
-            const auto graphic = label.value< QskGraphic >();
+            const auto graphic = label.value.value< QskGraphic >();
             if ( !graphic.isNull() )
-            {
-                w = graphic.widthForHeight( h );
-            }
+                label.size = QSizeF( graphic.widthForHeight( h ), h );
         }
-
-        maxWidth = qMax( w, maxWidth );
     }
 
-    return QSizeF( maxWidth, h );
+    return label;
+}
+
+qreal QskScaleRenderer::textWidth( const QString& text ) const
+{
+    auto it = m_textWidths.constFind( text );
+    if ( it != m_textWidths.constEnd() )
+        return it.value();
+
+    /*
+        When the tickmarks are shifted continuously the cache would
+        grow forever. So we start over, when having more texts
+        than being displayed at the same time.
+     */
+    if ( m_textWidths.size() > 4 * m_tickmarks.majorTicks().size() )
+        m_textWidths.clear();
+
+    const auto w = qskHorizontalAdvance( QFontMetricsF( m_font ), text );
+    m_textWidths.insert( text, w );
+
+    return w;
 }
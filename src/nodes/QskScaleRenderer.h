@@ -15,11 +15,14 @@
 #include <qnamespace.h>
 #include <qfont.h>
 #include <qcolor.h>
+#include <qhash.h>
+#include <qsize.h>
+#include <qstring.h>
+#include <qvariant.h>
 
 class QskSkinnable;
 
 class QSGNode;
-class QVariant;
 class QRectF;
 
 class QSK_EXPORT QskScaleRenderer
@@ -42,7 +45,7 @@ class QSK_EXPORT QskScaleRenderer
         const QRectF& tickmarksRect, const QRectF& labelsRect, QSGNode* );
 
     virtual QVariant labelAt( qreal pos ) const;
-    QSizeF boundingLabelSize() const; 
+    QSizeF boundingLabelSize() const;
 
     virtual QSGNode* updateTicksNode(
         const QskSkinnable*, const QRectF&, QSGNode* ) const;
@@ -52,6 +55,16 @@ class QSK_EXPORT QskScaleRenderer
         const QRectF& labelsRect, QSGNode* node ) const;
 
   private:
+    class Label
+    {
+      public:
+        QVariant value;
+        QSizeF size;
+    };
+
+    Label label( qreal tick ) const;
+    qreal textWidth( const QString& ) const;
+
     Qt::Orientation m_orientation = Qt::Horizontal;
 
     QskIntervalF m_boundaries;
@@ -64,6 +77,9 @@ class QSK_EXPORT QskScaleRenderer
     QskTextColors m_textColors;
 
     QskColorFilter m_colorFilter;
+
+    // the widths of the texts, as measuring is expensive
+    mutable QHash< QString, qreal > m_textWidths;
 };
 
 #endif
@@ -0,0 +1,384 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskSoftwareBoxNode.h"
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 8, 0 )
+
+#include "QskBoxBorderColors.h"
+#include "QskBoxBorderMetrics.h"
+#include "QskBoxShapeMetrics.h"
+#include "QskGradient.h"
+
+#include <qimage.h>
+#include <qmath.h>
+#include <qpainter.h>
+#include <qpainterpath.h>
+#include <qquickwindow.h>
+#include <qsgrendererinterface.h>
+
+static inline uint qskBoxHash( const QRectF& rect,
+    const QskBoxShapeMetrics& shape, const QskBoxBorderMetrics& borderMetrics,
+    const QskBoxBorderColors& borderColors, const QskGradient& gradient )
+{
+    uint hash = 15000;
+
+    hash = qHashBits( &rect, sizeof( rect ), hash );
+    hash = shape.hash( hash );
+    hash = borderMetrics.hash( hash );
+    hash = borderColors.hash( hash );
+
+    return gradient.hash( hash );
+}
+
+static QPainterPath qskRoundedPath( const QRectF& rect, const QSizeF radii[ 4 ] )
+{
+    const auto& tl = radii[ Qt::TopLeftCorner ];
+    const auto& tr = radii[ Qt::TopRightCorner ];
+    const auto& bl = radii[ Qt::BottomLeftCorner ];
+    const auto& br = radii[ Qt::BottomRightCorner ];
+
+    QPainterPath path;
+
+    path.moveTo( rect.left(), rect.top() + tl.height() );
+
+    if ( !tl.isEmpty() )
+    {
+        path.arcTo( QRectF( rect.left(), rect.top(),
+            2.0 * tl.width(), 2.0 * tl.height() ), 180.0, -90.0 );
+    }
+
+    path.lineTo( rect.right() - tr.width(), rect.top() );
+
+    if ( !tr.isEmpty() )
+    {
+        path.arcTo( QRectF( rect.right() - 2.0 * tr.width(), rect.top(),
+            2.0 * tr.width(), 2.0 * tr.height() ), 90.0, -90.0 );
+    }
+
+    path.lineTo( rect.right(), rect.bottom() - br.height() );
+
+    if ( !br.isEmpty() )
+    {
+        path.arcTo( QRectF( rect.right() - 2.0 * br.width(),
+            rect.bottom() - 2.0 * br.height(),
+            2.0 * br.width(), 2.0 * br.height() ), 0.0, -90.0 );
+    }
+
+    path.lineTo( rect.left() + bl.width(), rect.bottom() );
+
+    if ( !bl.isEmpty() )
+    {
+        path.arcTo( QRectF( rect.left(), rect.bottom() - 2.0 * bl.height(),
+            2.0 * bl.width(), 2.0 * bl.height() ), 270.0, -90.0 );
+    }
+
+    path.closeSubpath();
+
+    return path;
+}
+
+static QBrush qskGradientBrush( const QskGradient& gradient, const QRectF& rect )
+{
+    if ( gradient.isMonochrome() )
+        return QBrush( gradient.startColor() );
+
+    QLinearGradient linearGradient;
+
+    switch ( gradient.orientation() )
+    {
+        case QskGradient::Horizontal:
+            linearGradient.setStart( rect.topLeft() );
+            linearGradient.setFinalStop( rect.topRight() );
+            break;
+
+        case QskGradient::Vertical:
+            linearGradient.setStart( rect.topLeft() );
+            linearGradient.setFinalStop( rect.bottomLeft() );
+            break;
+
+        default:
+            linearGradient.setStart( rect.topLeft() );
+            linearGradient.setFinalStop( rect.bottomRight() );
+    }
+
+    for ( const auto& stop : gradient.stops() )
+        linearGradient.setColorAt( stop.position(), stop.color() );
+
+    return QBrush( linearGradient );
+}
+
+namespace
+{
+    class Box
+    {
+      public:
+        void paint( QPainter* painter ) const
+        {
+            const auto bw = borderMetrics.widths();
+
+            const auto innerRect = rect.adjusted(
+                bw.left(), bw.top(), -bw.right(), -bw.bottom() );
+
+            if ( shape.isRectangle() )
+                paintRectangle( painter, innerRect );
+            else
+                paintRounded( painter, innerRect );
+        }
+
+        bool isRectangle() const
+        {
+            return shape.isRectangle();
+        }
+
+        QRectF rect;
+
+        QskBoxShapeMetrics shape;
+        QskBoxBorderMetrics borderMetrics;
+        QskBoxBorderColors borderColors;
+        QskGradient gradient;
+
+      private:
+        void paintRectangle( QPainter* painter, const QRectF& innerRect ) const
+        {
+            if ( borderColors.isVisible() && !borderMetrics.isNull() )
+            {
+                const auto bw = borderMetrics.widths();
+
+                // top/bottom are covering the corners
+
+                painter->fillRect( QRectF( rect.left(), rect.top(),
+                    rect.width(), bw.top() ), borderColors.color( Qsk::Top ) );
+
+                painter->fillRect( QRectF( rect.left(), rect.bottom() - bw.bottom(),
+                    rect.width(), bw.bottom() ), borderColors.color( Qsk::Bottom ) );
+
+                painter->fillRect( QRectF( rect.left(), innerRect.top(),
+                    bw.left(), innerRect.height() ), borderColors.color( Qsk::Left ) );
+
+                painter->fillRect( QRectF( innerRect.right(), innerRect.top(),
+                    bw.right(), innerRect.height() ), borderColors.color( Qsk::Right ) );
+            }
+
+            if ( gradient.isValid() && innerRect.isValid() )
+                painter->fillRect( innerRect, qskGradientBrush( gradient, innerRect ) );
+        }
+
+        void paintRounded( QPainter* painter, const QRectF& innerRect ) const
+        {
+            const auto bw = borderMetrics.widths();
+
+            QSizeF radii[ 4 ];
+            QSizeF innerRadii[ 4 ];
+
+            for ( int i = 0; i < 4; i++ )
+            {
+                const auto corner = static_cast< Qt::Corner >( i );
+
+                auto r = shape.radius( corner );
+                r.setWidth( qBound( 0.0, r.width(), 0.5 * rect.width() ) );
+                r.setHeight( qBound( 0.0, r.height(), 0.5 * rect.height() ) );
+
+                radii[ i ] = r;
+
+                const qreal bx = ( corner == Qt::TopLeftCorner
+                    || corner == Qt::BottomLeftCorner ) ? bw.left() : bw.right();
+
+                const qreal by = ( corner == Qt::TopLeftCorner
+                    || corner == Qt::TopRightCorner ) ? bw.top() : bw.bottom();
+
+                innerRadii[ i ] = QSizeF( qMax( r.width() - bx, 0.0 ),
+                    qMax( r.height() - by, 0.0 ) );
+            }
+
+            painter->setRenderHint( QPainter::Antialiasing, true );
+            painter->setPen( Qt::NoPen );
+
+            const auto outerPath = qskRoundedPath( rect, radii );
+
+            QPainterPath innerPath;
+            if ( innerRect.isValid() )
+                innerPath = qskRoundedPath( innerRect, innerRadii );
+
+            if ( borderColors.isVisible() && !borderMetrics.isNull() )
+            {
+                QPainterPath borderPath = outerPath;
+                borderPath.addPath( innerPath );
+                borderPath.setFillRule( Qt::OddEvenFill );
+
+                if ( borderColors.isMonochrome() )
+                {
+                    painter->fillPath( borderPath, borderColors.color( Qsk::Left ) );
+                }
+                else
+                {
+                    /*
+                        Each side gets the trapezoid between the outer
+                        and the inner rectangle.
+                     */
+                    const QPointF o[] = { rect.topLeft(), rect.topRight(),
+                        rect.bottomRight(), rect.bottomLeft() };
+
+                    const QPointF i[] = { innerRect.topLeft(), innerRect.topRight(),
+                        innerRect.bottomRight(), innerRect.bottomLeft() };
+
+                    const Qsk::Position positions[] =
+                        { Qsk::Top, Qsk::Right, Qsk::Bottom, Qsk::Left };
+
+                    for ( int k = 0; k < 4; k++ )
+                    {
+                        const int k2 = ( k + 1 ) % 4;
+
+                        QPainterPath clipPath;
+                        clipPath.addPolygon( QPolygonF() << o[ k ] << o[ k2 ] << i[ k2 ] << i[ k ] );
+                        clipPath.closeSubpath();
+
+                        painter->fillPath( borderPath.intersected( clipPath ),
+                            borderColors.color( positions[ k ] ) );
+                    }
+                }
+            }
+
+            if ( gradient.isValid() && !innerPath.isEmpty() )
+                painter->fillPath( innerPath, qskGradientBrush( gradient, innerRect ) );
+        }
+    };
+}
+
+class QskSoftwareBoxNode::PrivateData
+{
+  public:
+    QQuickWindow* window = nullptr;
+
+    uint hash = 0;
+    Box box;
+
+    // rounded boxes are painted into this image once
+    QImage image;
+};
+
+QskSoftwareBoxNode::QskSoftwareBoxNode()
+    : m_data( new PrivateData() )
+{
+}
+
+QskSoftwareBoxNode::~QskSoftwareBoxNode()
+{
+}
+
+bool QskSoftwareBoxNode::isRequired( const QQuickWindow* window )
+{
+    if ( window == nullptr )
+        return false;
+
+    if ( auto renderer = window->rendererInterface() )
+        return renderer->graphicsApi() == QSGRendererInterface::Software;
+
+    return false;
+}
+
+void QskSoftwareBoxNode::setBoxData( QQuickWindow* window, const QRectF& rect,
+    const QskBoxShapeMetrics& shape, const QskBoxBorderMetrics& borderMetrics,
+    const QskBoxBorderColors& borderColors, const QskGradient& gradient )
+{
+    m_data->window = window;
+
+    const auto hash = qskBoxHash( rect, shape, borderMetrics, borderColors, gradient );
+    if ( hash == m_data->hash )
+        return;
+
+    m_data->hash = hash;
+
+    auto& box = m_data->box;
+
+    box.rect = rect;
+    box.shape = shape;
+    box.borderMetrics = borderMetrics;
+    box.borderColors = borderColors;
+    box.gradient = gradient;
+
+    m_data->image = QImage();
+
+    markDirty( QSGNode::DirtyMaterial );
+}
+
+void QskSoftwareBoxNode::render( const RenderState* state )
+{
+    const auto window = m_data->window;
+    const auto& box = m_data->box;
+
+    if ( window == nullptr || box.rect.isEmpty() )
+        return;
+
+    auto renderer = window->rendererInterface();
+
+    auto painter = static_cast< QPainter* >(
+        renderer->getResource( window, QSGRendererInterface::PainterResource ) );
+
+    if ( painter == nullptr )
+        return;
+
+    // the clip has to be set before the transformation
+    const auto clipRegion = state->clipRegion();
+    if ( clipRegion && !clipRegion->isEmpty() )
+        painter->setClipRegion( *clipRegion, Qt::ReplaceClip );
+
+    painter->setTransform( matrix()->toTransform() );
+    painter->setOpacity( inheritedOpacity() );
+
+    if ( box.isRectangle() )
+    {
+        // no antialiasing needed, QPainter is fast enough
+        box.paint( painter );
+        return;
+    }
+
+    const qreal ratio = window->effectiveDevicePixelRatio();
+
+    if ( m_data->image.isNull() || m_data->image.devicePixelRatio() != ratio )
+    {
+        const QSize size( qCeil( box.rect.width() * ratio ),
+            qCeil( box.rect.height() * ratio ) );
+
+        QImage image( size, QImage::Format_ARGB32_Premultiplied );
+        image.setDevicePixelRatio( ratio );
+        image.fill( Qt::transparent );
+
+        QPainter p( &image );
+        p.translate( -box.rect.topLeft() );
+        box.paint( &p );
+        p.end();
+
+        m_data->image = image;
+    }
+
+    const QRectF targetRect( box.rect.topLeft(),
+        QSizeF( m_data->image.size() ) / ratio );
+
+    painter->drawImage( targetRect, m_data->image );
+}
+
+void QskSoftwareBoxNode::releaseResources()
+{
+    m_data->image = QImage();
+}
+
+QSGRenderNode::StateFlags QskSoftwareBoxNode::changedStates() const
+{
+    // the software backend does not care
+    return QSGRenderNode::StateFlags();
+}
+
+QSGRenderNode::RenderingFlags QskSoftwareBoxNode::flags() const
+{
+    return QSGRenderNode::BoundedRectRendering;
+}
+
+QRectF QskSoftwareBoxNode::rect() const
+{
+    return m_data->box.rect;
+}
+
+#endif
@@ -0,0 +1,61 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_SOFTWARE_BOX_NODE_H
+#define QSK_SOFTWARE_BOX_NODE_H
+
+#include "QskGlobal.h"
+
+#include <qsgnode.h>
+#include <memory>
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 8, 0 )
+#include <qsgrendernode.h>
+#endif
+
+class QskBoxShapeMetrics;
+class QskBoxBorderMetrics;
+class QskBoxBorderColors;
+class QskGradient;
+class QQuickWindow;
+
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 8, 0 )
+
+/*
+    The software backend of Qt/Quick does not render geometry nodes,
+    what makes QskBoxNode useless there.
+
+    QskSoftwareBoxNode paints the box with QPainter instead. Rectangular
+    boxes are painted directly, while boxes with rounded corners are
+    painted into an image once, that is drawn until the box changes.
+ */
+class QSK_EXPORT QskSoftwareBoxNode : public QSGRenderNode
+{
+  public:
+    QskSoftwareBoxNode();
+    ~QskSoftwareBoxNode() override;
+
+    void setBoxData( QQuickWindow*, const QRectF&,
+        const QskBoxShapeMetrics&, const QskBoxBorderMetrics&,
+        const QskBoxBorderColors&, const QskGradient& );
+
+    // true, when the window is rendered by the software backend
+    static bool isRequired( const QQuickWindow* );
+
+    void render( const RenderState* ) override;
+    void releaseResources() override;
+
+    StateFlags changedStates() const override;
+    RenderingFlags flags() const override;
+    QRectF rect() const override;
+
+  private:
+    class PrivateData;
+    std::unique_ptr< PrivateData > m_data;
+};
+
+#endif
+
+#endif
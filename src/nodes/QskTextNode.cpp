@@ -4,6 +4,7 @@
  *****************************************************************************/
 
 #include "QskTextNode.h"
+#include "QskNodeStatistics.h"
 #include "QskTextColors.h"
 #include "QskTextOptions.h"
 #include "QskTextRenderer.h"
@@ -11,13 +12,15 @@
 #include <qfont.h>
 #include <qstring.h>
 
-static inline uint qskHash(
+static inline uint qskHash( const QQuickItem* item,
     const QString& text, const QSizeF& size, const QFont& font,
     const QskTextOptions& options, const QskTextColors& colors,
     Qt::Alignment alignment, Qsk::TextStyle textStyle )
 {
     uint hash = 11000;
 
+    // nodes might be recycled for different items: see QskNodePool
+    hash = qHash( item, hash );
     hash = qHash( text, hash );
     hash = qHash( font, hash );
     hash = qHash( options, hash );
@@ -49,13 +52,15 @@ void QskTextNode::setTextData(
     if ( matrix != this->matrix() ) // avoid setting DirtyMatrix accidently
         setMatrix( matrix );
 
-    const uint hash = qskHash( text, rect.size(), font,
+    const uint hash = qskHash( item, text, rect.size(), font,
         options, colors, alignment, textStyle );
 
     if ( hash != m_hash )
     {
         m_hash = hash;
 
+        QskNodeStatistics::increment( QskNodeStatistics::TextLayouts );
+
         const QRectF textRect( 0, 0, rect.width(), rect.height() );
 
         /*
@@ -0,0 +1,461 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskTextureAtlas.h"
+#include "QskNodeStatistics.h"
+
+#include <qatomic.h>
+#include <qhash.h>
+#include <qimage.h>
+#include <qmutex.h>
+#include <qopenglcontext.h>
+#include <qopenglfunctions.h>
+#include <qopengltexture.h>
+#include <qpainter.h>
+#include <qrect.h>
+#include <qvector.h>
+
+/*
+    The size of the atlas textures. Contexts not supporting
+    textures of this size will not use the atlas at all.
+ */
+static const int qskAtlasSize = 1024;
+
+/*
+    Each image is surrounded by a transparent frame, so that
+    sampling at the borders never picks up pixels of its neighbours.
+ */
+static const int qskPadding = 1;
+
+static QAtomicInt qskMaxImageSize( 64 );
+
+namespace
+{
+    class Slot
+    {
+      public:
+        int x;
+        int width;
+    };
+
+    /*
+        A simple shelf packing: images are aligned in rows ( shelves )
+        of a fixed height. Released slots are recycled for images, that fit
+        into them.
+     */
+    class Shelf
+    {
+      public:
+        bool allocate( int width, int& x )
+        {
+            for ( int i = 0; i < freeSlots.size(); i++ )
+            {
+                auto& slot = freeSlots[ i ];
+
+                if ( slot.width >= width )
+                {
+                    x = slot.x;
+
+                    slot.x += width;
+                    slot.width -= width;
+
+                    if ( slot.width == 0 )
+                        freeSlots.remove( i );
+
+                    return true;
+                }
+            }
+
+            if ( end + width <= qskAtlasSize )
+            {
+                x = end;
+                end += width;
+
+                return true;
+            }
+
+            return false;
+        }
+
+        void release( int x, int width )
+        {
+            if ( x + width == end )
+            {
+                end = x;
+            }
+            else
+            {
+                int i = 0;
+                while ( i < freeSlots.size() && freeSlots[ i ].x < x )
+                    i++;
+
+                freeSlots.insert( i, Slot { x, width } );
+            }
+
+            // merging adjacent slots
+
+            for ( int i = freeSlots.size() - 1; i > 0; i-- )
+            {
+                auto& s1 = freeSlots[ i - 1 ];
+                const auto& s2 = freeSlots[ i ];
+
+                if ( s1.x + s1.width == s2.x )
+                {
+                    s1.width += s2.width;
+                    freeSlots.remove( i );
+                }
+            }
+
+            if ( !freeSlots.isEmpty() )
+            {
+                const auto& last = freeSlots.last();
+                if ( last.x + last.width == end )
+                {
+                    end = last.x;
+                    freeSlots.removeLast();
+                }
+            }
+        }
+
+        int y;
+        int height;
+        int end;
+
+        QVector< Slot > freeSlots;
+    };
+
+    class Page
+    {
+      public:
+        Page( QOpenGLContext* context )
+        {
+            auto& f = *context->functions();
+
+            const auto target = QOpenGLTexture::Target2D;
+
+            GLint oldTexture;
+            f.glGetIntegerv( QOpenGLTexture::BindingTarget2D, &oldTexture );
+
+            f.glGenTextures( 1, &textureId );
+            f.glBindTexture( target, textureId );
+
+            f.glTexParameteri( target, GL_TEXTURE_MIN_FILTER, QOpenGLTexture::Nearest );
+            f.glTexParameteri( target, GL_TEXTURE_MAG_FILTER, QOpenGLTexture::Nearest );
+
+            f.glTexParameteri( target, GL_TEXTURE_WRAP_S, QOpenGLTexture::ClampToEdge );
+            f.glTexParameteri( target, GL_TEXTURE_WRAP_T, QOpenGLTexture::ClampToEdge );
+
+            f.glTexImage2D( target, 0, QOpenGLTexture::RGBA8_UNorm,
+                qskAtlasSize, qskAtlasSize, 0,
+                QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, nullptr );
+
+            f.glBindTexture( target, oldTexture );
+        }
+
+        bool allocate( const QSize& size, QRect& rect )
+        {
+            const int w = size.width() + 2 * qskPadding;
+            const int h = size.height() + 2 * qskPadding;
+
+            /*
+                Avoiding to waste too much space by putting
+                small images into shelves for large ones.
+             */
+            const int maxHeight = h + h / 2;
+
+            int x;
+
+            for ( auto& shelf : shelves )
+            {
+                if ( shelf.height >= h && shelf.height <= maxHeight )
+                {
+                    if ( shelf.allocate( w, x ) )
+                    {
+                        rect.setRect( x, shelf.y, w, h );
+                        count++;
+
+                        return true;
+                    }
+                }
+            }
+
+            if ( nextY + h > qskAtlasSize )
+                return false;
+
+            Shelf shelf;
+            shelf.y = nextY;
+            shelf.height = h;
+            shelf.end = 0;
+
+            shelf.allocate( w, x );
+            shelves += shelf;
+
+            nextY += h;
+
+            rect.setRect( x, shelf.y, w, h );
+            count++;
+
+            return true;
+        }
+
+        void release( const QRect& rect )
+        {
+            for ( auto& shelf : shelves )
+            {
+                if ( shelf.y == rect.y() )
+                {
+                    shelf.release( rect.x(), rect.width() );
+                    break;
+                }
+            }
+
+            if ( --count == 0 )
+            {
+                shelves.clear();
+                nextY = 0;
+            }
+        }
+
+        GLuint textureId = 0;
+
+        QVector< Shelf > shelves;
+        int nextY = 0;
+
+        int count = 0;
+    };
+
+    class Atlas
+    {
+      public:
+        Atlas( QOpenGLContext* context )
+            : context( context )
+        {
+            GLint maxSize = 0;
+            context->functions()->glGetIntegerv( GL_MAX_TEXTURE_SIZE, &maxSize );
+
+            isValid = maxSize >= qskAtlasSize;
+        }
+
+        ~Atlas()
+        {
+            /*
+                The pages are deleted, when the scene graph invalidates
+                its context ( see removeAtlas ) - usually being current then.
+                Otherwise the textures are gone with the context anyway.
+             */
+            if ( QOpenGLContext::currentContext() == context )
+            {
+                auto& f = *context->functions();
+
+                for ( const auto page : qskAsConst( pages ) )
+                    f.glDeleteTextures( 1, &page->textureId );
+            }
+
+            qDeleteAll( pages );
+        }
+
+        uint insert( const QImage& image, QRect& rect )
+        {
+            if ( !isValid )
+                return 0;
+
+            Page* page = nullptr;
+
+            for ( auto p : qskAsConst( pages ) )
+            {
+                if ( p->allocate( image.size(), rect ) )
+                {
+                    page = p;
+                    break;
+                }
+            }
+
+            if ( page == nullptr )
+            {
+                page = new Page( context );
+                pages += page;
+
+                if ( !page->allocate( image.size(), rect ) )
+                    return 0;
+            }
+
+            upload( page->textureId, image, rect );
+
+            // the padding is not part of the image
+            rect.adjust( qskPadding, qskPadding, -qskPadding, -qskPadding );
+
+            return page->textureId;
+        }
+
+        void release( uint textureId, const QRect& rect )
+        {
+            for ( int i = 0; i < pages.size(); i++ )
+            {
+                auto page = pages[ i ];
+
+                if ( page->textureId == textureId )
+                {
+                    page->release( rect.adjusted(
+                        -qskPadding, -qskPadding, qskPadding, qskPadding ) );
+
+                    // keeping one page for the next images
+                    if ( page->count == 0 && pages.size() > 1
+                        && QOpenGLContext::currentContext() == context )
+                    {
+                        context->functions()->glDeleteTextures( 1, &page->textureId );
+
+                        pages.remove( i );
+                        delete page;
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        QOpenGLContext* context;
+        QVector< Page* > pages;
+
+        bool isValid;
+
+      private:
+        void upload( GLuint textureId, const QImage& image, const QRect& rect )
+        {
+            QImage img( rect.size(), QImage::Format_RGBA8888_Premultiplied );
+            img.fill( Qt::transparent );
+
+            {
+                QPainter painter( &img );
+                painter.setCompositionMode( QPainter::CompositionMode_Source );
+                painter.drawImage( qskPadding, qskPadding, image );
+            }
+
+            const auto target = QOpenGLTexture::Target2D;
+
+            auto& f = *context->functions();
+
+            GLint oldTexture;
+            f.glGetIntegerv( QOpenGLTexture::BindingTarget2D, &oldTexture );
+
+            f.glBindTexture( target, textureId );
+
+            QskNodeStatistics::increment( QskNodeStatistics::TextureUploads );
+
+            f.glTexSubImage2D( target, 0, rect.x(), rect.y(),
+                img.width(), img.height(),
+                QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, img.constBits() );
+
+            f.glBindTexture( target, oldTexture );
+        }
+    };
+
+    class AtlasMap
+    {
+      public:
+        ~AtlasMap()
+        {
+            qDeleteAll( m_atlases );
+        }
+
+        Atlas* atlas( bool create )
+        {
+            auto context = QOpenGLContext::currentContext();
+            if ( context == nullptr )
+                return nullptr;
+
+            QMutexLocker locker( &m_mutex );
+
+            auto atlas = m_atlases.value( context, nullptr );
+            if ( atlas == nullptr && create )
+            {
+                atlas = new Atlas( context );
+                m_atlases.insert( context, atlas );
+
+                QObject::connect( context, &QOpenGLContext::aboutToBeDestroyed,
+                    context, [ this, context ] { removeAtlas( context ); },
+                    Qt::DirectConnection );
+            }
+
+            return atlas;
+        }
+
+      private:
+        void removeAtlas( const QOpenGLContext* context )
+        {
+            Atlas* atlas;
+
+            {
+                QMutexLocker locker( &m_mutex );
+                atlas = m_atlases.take( context );
+            }
+
+            delete atlas;
+        }
+
+        QMutex m_mutex;
+        QHash< const QOpenGLContext*, Atlas* > m_atlases;
+    };
+}
+
+Q_GLOBAL_STATIC( AtlasMap, qskAtlasMap )
+
+static inline Atlas* qskAtlas( bool create )
+{
+    if ( qskAtlasMap.isDestroyed() )
+        return nullptr;
+
+    return qskAtlasMap->atlas( create );
+}
+
+void QskTextureAtlas::setMaxImageSize( int size )
+{
+    size = qBound( 0, size, qskAtlasSize / 4 );
+    qskMaxImageSize.storeRelease( size );
+}
+
+int QskTextureAtlas::maxImageSize()
+{
+    return qskMaxImageSize.loadAcquire();
+}
+
+bool QskTextureAtlas::isCandidate( const QSize& size )
+{
+    const int maxSize = maxImageSize();
+
+    return !size.isEmpty() &&
+        ( size.width() <= maxSize ) && ( size.height() <= maxSize );
+}
+
+uint QskTextureAtlas::insertImage( const QImage& image, QRect* rect )
+{
+    if ( image.isNull() || !isCandidate( image.size() ) )
+        return 0;
+
+    auto atlas = qskAtlas( true );
+    if ( atlas == nullptr )
+        return 0;
+
+    QRect r;
+
+    const auto textureId = atlas->insert( image, r );
+    if ( textureId && rect )
+        *rect = r;
+
+    return textureId;
+}
+
+void QskTextureAtlas::releaseImage( uint textureId, const QRect& rect )
+{
+    if ( auto atlas = qskAtlas( false ) )
+        atlas->release( textureId, rect );
+}
+
+QRectF QskTextureAtlas::textureRect( const QRect& rect )
+{
+    const qreal f = 1.0 / qskAtlasSize;
+
+    return QRectF( rect.x() * f, rect.y() * f,
+        rect.width() * f, rect.height() * f );
+}
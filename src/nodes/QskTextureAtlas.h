@@ -0,0 +1,45 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_TEXTURE_ATLAS_H
+#define QSK_TEXTURE_ATLAS_H
+
+#include "QskGlobal.h"
+
+class QImage;
+class QSize;
+class QRect;
+class QRectF;
+
+/*
+    Small images ( f.e icons ) are packed into a couple of large
+    textures, so that nodes showing them can be batched by the scene graph
+    renderer instead of ending up in a draw call for each of them.
+
+    The atlas textures are bound to the OpenGL context being current,
+    when calling the functions below.
+ */
+namespace QskTextureAtlas
+{
+    // images up to this size ( width and height ) are accepted
+    QSK_EXPORT void setMaxImageSize( int );
+    QSK_EXPORT int maxImageSize();
+
+    QSK_EXPORT bool isCandidate( const QSize& );
+
+    /*
+        Copies the image into one of the atlas textures and returns
+        its id, or 0 when the image could not be inserted. The position
+        of the image inside the atlas is returned in pixels.
+     */
+    QSK_EXPORT uint insertImage( const QImage&, QRect* );
+
+    QSK_EXPORT void releaseImage( uint textureId, const QRect& );
+
+    // the rectangle in normalized texture coordinates
+    QSK_EXPORT QRectF textureRect( const QRect& );
+}
+
+#endif
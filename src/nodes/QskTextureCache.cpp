@@ -0,0 +1,286 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskTextureCache.h"
+#include "QskTextureAtlas.h"
+
+#include <qatomic.h>
+#include <qhash.h>
+#include <qmap.h>
+#include <qmutex.h>
+#include <qopenglcontext.h>
+#include <qopenglfunctions.h>
+#include <qrect.h>
+#include <qsize.h>
+
+namespace
+{
+    class Key
+    {
+      public:
+        inline bool operator==( const Key& other ) const
+        {
+            return ( hash == other.hash ) &&
+                ( width == other.width ) && ( height == other.height );
+        }
+
+        uint hash;
+        int width;
+        int height;
+    };
+
+    inline uint qHash( const Key& key, uint seed = 0 )
+    {
+        uint h = ::qHash( key.hash, seed );
+        h = ::qHash( key.width, h );
+        h = ::qHash( key.height, h );
+
+        return h;
+    }
+
+    inline Key qskKey( uint hash, const QSize& size )
+    {
+        return { hash, size.width(), size.height() };
+    }
+
+    class Entry
+    {
+      public:
+        uint textureId;
+        int refCount;
+        quint64 stamp;
+
+        QRect atlasRect;
+    };
+
+    class Cache
+    {
+      public:
+        Cache( QOpenGLContext* context )
+            : context( context )
+        {
+        }
+
+        ~Cache()
+        {
+            for ( auto it = entries.constBegin(); it != entries.constEnd(); ++it )
+            {
+                // the atlas textures are deleted by QskTextureAtlas
+                if ( !it.value().atlasRect.isValid() )
+                    deleteTexture( it.value().textureId );
+            }
+        }
+
+        void setUnused( const Key& key, Entry& entry )
+        {
+            entry.stamp = ++lastStamp;
+
+            unused.insert( entry.stamp, key );
+            unusedCost += qskCost( key );
+        }
+
+        void setUsed( const Key& key, Entry& entry )
+        {
+            unused.remove( entry.stamp );
+            unusedCost -= qskCost( key );
+
+            entry.stamp = 0;
+        }
+
+        void evict( qint64 maxCost )
+        {
+            while ( ( unusedCost > maxCost ) && !unused.isEmpty() )
+            {
+                const auto key = unused.take( unused.firstKey() );
+                unusedCost -= qskCost( key );
+
+                const auto entry = entries.take( key );
+
+                if ( entry.atlasRect.isValid() )
+                    QskTextureAtlas::releaseImage( entry.textureId, entry.atlasRect );
+                else
+                    deleteTexture( entry.textureId );
+            }
+        }
+
+        QOpenGLContext* context;
+
+        QHash< Key, Entry > entries;
+
+        // the unused entries, ordered by the time of their last release
+        QMap< quint64, Key > unused;
+        qint64 unusedCost = 0;
+
+        quint64 lastStamp = 0;
+
+      private:
+        static inline qint64 qskCost( const Key& key )
+        {
+            return qint64( key.width ) * key.height * 4;
+        }
+
+        void deleteTexture( uint textureId )
+        {
+            /*
+                In certain environments we have the effect, that at
+                program termination the context is already gone
+             */
+            if ( textureId && ( QOpenGLContext::currentContext() == context ) )
+            {
+                GLuint id = textureId;
+                context->functions()->glDeleteTextures( 1, &id );
+            }
+        }
+    };
+
+    class CacheMap
+    {
+      public:
+        ~CacheMap()
+        {
+            qDeleteAll( m_caches );
+        }
+
+        Cache* cache( bool create )
+        {
+            auto context = QOpenGLContext::currentContext();
+            if ( context == nullptr )
+                return nullptr;
+
+            QMutexLocker locker( &m_mutex );
+
+            auto cache = m_caches.value( context, nullptr );
+            if ( cache == nullptr && create )
+            {
+                cache = new Cache( context );
+                m_caches.insert( context, cache );
+
+                QObject::connect( context, &QOpenGLContext::aboutToBeDestroyed,
+                    context, [ this, context ] { removeCache( context ); },
+                    Qt::DirectConnection );
+            }
+
+            return cache;
+        }
+
+      private:
+        void removeCache( const QOpenGLContext* context )
+        {
+            Cache* cache;
+
+            {
+                QMutexLocker locker( &m_mutex );
+                cache = m_caches.take( context );
+            }
+
+            delete cache;
+        }
+
+        QMutex m_mutex;
+        QHash< const QOpenGLContext*, Cache* > m_caches;
+    };
+}
+
+Q_GLOBAL_STATIC( CacheMap, qskCacheMap )
+
+static QAtomicInteger< qint64 > qskMaxUnusedCost( 8 * 1024 * 1024 );
+
+static inline Cache* qskCache( bool create )
+{
+    // nodes might be released after the global cleanup
+    if ( qskCacheMap.isDestroyed() )
+        return nullptr;
+
+    return qskCacheMap->cache( create );
+}
+
+uint QskTextureCache::acquireTexture(
+    uint hash, const QSize& size, QRect* atlasRect )
+{
+    auto cache = qskCache( false );
+    if ( cache == nullptr )
+        return 0;
+
+    const auto key = qskKey( hash, size );
+
+    auto it = cache->entries.find( key );
+    if ( it == cache->entries.end() )
+        return 0;
+
+    auto& entry = it.value();
+
+    if ( entry.refCount++ == 0 )
+        cache->setUsed( key, entry );
+
+    if ( atlasRect )
+        *atlasRect = entry.atlasRect;
+
+    return entry.textureId;
+}
+
+bool QskTextureCache::insertTexture(
+    uint hash, const QSize& size, uint textureId )
+{
+    return insertTexture( hash, size, textureId, QRect() );
+}
+
+bool QskTextureCache::insertTexture( uint hash,
+    const QSize& size, uint textureId, const QRect& atlasRect )
+{
+    if ( textureId == 0 )
+        return false;
+
+    auto cache = qskCache( true );
+    if ( cache == nullptr )
+        return false;
+
+    const auto key = qskKey( hash, size );
+
+    if ( cache->entries.contains( key ) )
+    {
+        // should never happen, as we always try to acquire first
+        return false;
+    }
+
+    cache->entries.insert( key, { textureId, 1, 0, atlasRect } );
+    return true;
+}
+
+void QskTextureCache::releaseTexture( uint hash, const QSize& size )
+{
+    auto cache = qskCache( false );
+    if ( cache == nullptr )
+        return;
+
+    const auto key = qskKey( hash, size );
+
+    auto it = cache->entries.find( key );
+    if ( it == cache->entries.end() )
+        return;
+
+    auto& entry = it.value();
+
+    if ( --entry.refCount == 0 )
+    {
+        cache->setUnused( key, entry );
+        cache->evict( qskMaxUnusedCost.loadAcquire() );
+    }
+}
+
+void QskTextureCache::setMaxUnusedCost( qint64 cost )
+{
+    qskMaxUnusedCost.storeRelease( qMax( cost, qint64( 0 ) ) );
+}
+
+qint64 QskTextureCache::maxUnusedCost()
+{
+    return qskMaxUnusedCost.loadAcquire();
+}
+
+void QskTextureCache::clearUnused()
+{
+    if ( auto cache = qskCache( false ) )
+        cache->evict( 0 );
+}
@@ -0,0 +1,56 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_TEXTURE_CACHE_H
+#define QSK_TEXTURE_CACHE_H
+
+#include "QskGlobal.h"
+
+class QSize;
+class QRect;
+
+/*
+    A cache for textures, that are rendered from the same input
+    ( f.e. the same graphic/color filter ) and might be shared
+    between several nodes.
+
+    Textures are bound to the OpenGL context being current, when
+    calling the functions below. Without a current context the cache
+    is not available and all calls are ignored.
+
+    Textures in use are reference counted. When the last reference
+    has been released the texture stays in the cache until it gets
+    evicted - least recently used first - when the memory consumed
+    by unused textures exceeds maxUnusedCost().
+ */
+namespace QskTextureCache
+{
+    /*
+        returns 0, when not being found. For textures, that are
+        part of a QskTextureAtlas the position inside the atlas is returned.
+     */
+    QSK_EXPORT uint acquireTexture( uint hash, const QSize&, QRect* atlasRect = nullptr );
+
+    /*
+        The cache takes ownership, the texture starts with one reference.
+        A valid atlasRect indicates a texture, that has been inserted into
+        QskTextureAtlas and needs to be released there.
+     */
+    QSK_EXPORT bool insertTexture( uint hash, const QSize&,
+        uint textureId, const QRect& atlasRect );
+
+    QSK_EXPORT bool insertTexture( uint hash, const QSize&, uint textureId );
+
+    QSK_EXPORT void releaseTexture( uint hash, const QSize& );
+
+    // bytes of the unused textures, that are kept in the cache
+    QSK_EXPORT void setMaxUnusedCost( qint64 );
+    QSK_EXPORT qint64 maxUnusedCost();
+
+    // deleting the unused textures of the current context
+    QSK_EXPORT void clearUnused();
+}
+
+#endif
@@ -21,7 +21,8 @@ QSK_QT_PRIVATE_BEGIN
 #include <private/qrhigles2_p_p.h>
 QSK_QT_PRIVATE_END
 
-static void qskUpdateGLTextureId( QRhiTexture* rhiTexture, uint textureId )
+static void qskUpdateGLTextureId(
+    QRhiTexture* rhiTexture, uint textureId, bool ownsTexture )
 {
     // hack time: we do not want to create a new QSGTexture object for each texture
 
@@ -34,7 +35,7 @@ static void qskUpdateGLTextureId( QRhiTexture* rhiTexture, uint textureId )
 
     GLuint id = rhiTexture->nativeTexture().object;
 
-    if ( id )
+    if ( id && ownsTexture )
     {
         auto funcs = QOpenGLContext::currentContext()->functions();
         funcs->glDeleteTextures( 1, &id );
@@ -49,9 +50,30 @@ static void qskUpdateGLTextureId( QRhiTexture* rhiTexture, uint textureId )
 using TextureMaterial = QSGTextureMaterial;
 using OpaqueTextureMaterial = QSGOpaqueTextureMaterial;
 
-static inline void qskDeleteTexture( const TextureMaterial& material )
+static inline void qskDeleteTexture(
+    const TextureMaterial& material, bool ownsTexture )
 {
-    delete material.texture();
+    auto texture = material.texture();
+    if ( texture == nullptr )
+        return;
+
+    /*
+        The wrapper created by QSGOpenGLTexture::fromNative does not own
+        the OpenGL texture. So the wrapper is always deleted, but the
+        texture only, when it is not shared ( cache/atlas ).
+     */
+    if ( ownsTexture )
+    {
+        GLuint id = texture->rhiTexture()->nativeTexture().object;
+
+        if ( id > 0 )
+        {
+            if ( auto context = QOpenGLContext::currentContext() )
+                context->functions()->glDeleteTextures( 1, &id );
+        }
+    }
+
+    delete texture;
 }
 
 #endif
@@ -207,9 +229,10 @@ namespace
     }
 }
 
-static inline void qskDeleteTexture( const TextureMaterial& material )
+static inline void qskDeleteTexture(
+    const TextureMaterial& material, bool ownsTexture )
 {
-    if ( material.textureId() > 0 )
+    if ( ownsTexture && material.textureId() > 0 )
     {
         /*
             In certain environments we have the effect, that at
@@ -232,6 +255,7 @@ class QskTextureNodePrivate final : public QSGGeometryNodePrivate
   public:
     QskTextureNodePrivate()
         : geometry( QSGGeometry::defaultAttributes_TexturedPoint2D(), 4 )
+        , ownsTexture( true )
     {
     }
 
@@ -239,18 +263,18 @@ class QskTextureNodePrivate final : public QSGGeometryNodePrivate
 
     void updateTextureGeometry( const QQuickWindow* window )
     {
-        QRectF r( 0, 0, 1, 1 );
+        QRectF r = textureRect;
 
         if ( this->mirrored & Qt::Horizontal )
         {
-            r.setLeft( 1 );
-            r.setRight( 0 );
+            r.setLeft( textureRect.right() );
+            r.setRight( textureRect.left() );
         }
 
         if ( mirrored & Qt::Vertical )
         {
-            r.setTop( 1 );
-            r.setBottom( 0 );
+            r.setTop( textureRect.bottom() );
+            r.setBottom( textureRect.top() );
         }
 
         const qreal ratio = window->effectiveDevicePixelRatio();
@@ -267,7 +291,11 @@ class QskTextureNodePrivate final : public QSGGeometryNodePrivate
     TextureMaterial material;
 
     QRectF rect;
+    QRectF textureRect = { 0.0, 0.0, 1.0, 1.0 };
+
     Qt::Orientations mirrored;
+
+    bool ownsTexture : 1;
 };
 
 QskTextureNode::QskTextureNode()
@@ -284,18 +312,28 @@ QskTextureNode::QskTextureNode()
 QskTextureNode::~QskTextureNode()
 {
     Q_D( const QskTextureNode );
-    qskDeleteTexture( d->material );
+    qskDeleteTexture( d->material, d->ownsTexture );
 }
 
 void QskTextureNode::setTexture( QQuickWindow* window,
     const QRectF& rect, uint textureId,
     Qt::Orientations mirrored )
+{
+    setTexture( window, rect, textureId,
+        QRectF( 0.0, 0.0, 1.0, 1.0 ), mirrored );
+}
+
+void QskTextureNode::setTexture( QQuickWindow* window,
+    const QRectF& rect, uint textureId, const QRectF& textureRect,
+    Qt::Orientations mirrored )
 {
     Q_D( QskTextureNode );
 
-    if ( ( d->rect != rect ) || ( d->mirrored != mirrored ) )
+    if ( ( d->rect != rect ) || ( d->textureRect != textureRect )
+        || ( d->mirrored != mirrored ) )
     {
         d->rect = rect;
+        d->textureRect = textureRect;
         d->mirrored = mirrored;
 
         d->updateTextureGeometry( window );
@@ -313,7 +351,7 @@ void QskTextureNode::setTexture( QQuickWindow* window,
 
 void QskTextureNodePrivate::setTextureId( QQuickWindow*, uint textureId )
 {
-    qskDeleteTexture( this->material );
+    qskDeleteTexture( this->material, this->ownsTexture );
 
     this->material.setTextureId( textureId );
     this->opaqueMaterial.setTextureId( textureId );
@@ -342,7 +380,8 @@ void QskTextureNodePrivate::setTextureId( QQuickWindow* window, uint textureId )
         {
             case QSGRendererInterface::OpenGL:
             {
-                qskUpdateGLTextureId( texture->rhiTexture(), textureId );
+                qskUpdateGLTextureId( texture->rhiTexture(),
+                    textureId, this->ownsTexture );
                 break;
             }
             default:
@@ -391,8 +430,26 @@ QRectF QskTextureNode::rect() const
     return d->rect;
 }
 
+QRectF QskTextureNode::textureRect() const
+{
+    Q_D( const QskTextureNode );
+    return d->textureRect;
+}
+
 Qt::Orientations QskTextureNode::mirrored() const
 {
     Q_D( const QskTextureNode );
     return d->mirrored;
 }
+
+void QskTextureNode::setOwnsTexture( bool on )
+{
+    Q_D( QskTextureNode );
+    d->ownsTexture = on;
+}
+
+bool QskTextureNode::ownsTexture() const
+{
+    Q_D( const QskTextureNode );
+    return d->ownsTexture;
+}
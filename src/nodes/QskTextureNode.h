@@ -25,10 +25,26 @@ class QSK_EXPORT QskTextureNode : public QSGGeometryNode
     void setTexture( QQuickWindow*, const QRectF&, uint id,
         Qt::Orientations mirrored = Qt::Orientations() );
 
+    /*
+        Displaying a subrectangle ( in normalized coordinates )
+        of the texture - f.e. when being part of a QskTextureAtlas
+     */
+    void setTexture( QQuickWindow*, const QRectF&, uint id,
+        const QRectF& textureRect, Qt::Orientations mirrored = Qt::Orientations() );
+
     uint textureId() const;
     QRectF rect() const;
+    QRectF textureRect() const;
     Qt::Orientations mirrored() const;
 
+    /*
+        By default the node takes ownership of the texture and deletes
+        it, when being replaced or on destruction. Textures shared between
+        nodes ( f.e by QskTextureCache ) have to be managed elsewhere.
+     */
+    void setOwnsTexture( bool );
+    bool ownsTexture() const;
+
   private:
     Q_DECLARE_PRIVATE( QskTextureNode )
 };
@@ -6,6 +6,7 @@
 #include "QskTextureRenderer.h"
 #include "QskColorFilter.h"
 #include "QskGraphic.h"
+#include "QskNodeStatistics.h"
 #include "QskSetup.h"
 
 #include <qopenglcontext.h>
@@ -15,8 +16,12 @@
 #include <qopenglpaintdevice.h>
 #include <qopengltexture.h>
 
+#include <qatomic.h>
+#include <qhash.h>
 #include <qimage.h>
+#include <qmutex.h>
 #include <qpainter.h>
+#include <qvector.h>
 
 #include <qquickwindow.h>
 #include <qsgtexture.h>
@@ -25,9 +30,147 @@
     #include <qsgtexture_platform.h>
 #endif
 
+static QAtomicInteger< qint64 > qskMaxFramebufferCost( 4 * 1024 * 1024 );
+
+namespace
+{
+    /*
+        Creating and deleting framebuffer objects for each texture
+        is expensive on some platforms. So we keep the framebuffer objects
+        that have been used recently, until exceeding maxFramebufferCost().
+     */
+    class FramebufferPool
+    {
+      public:
+        ~FramebufferPool()
+        {
+            for ( const auto& entry : qskAsConst( m_entries ) )
+                delete entry.fbo;
+        }
+
+        QOpenGLFramebufferObject* take( const QSize& size,
+            const QOpenGLFramebufferObjectFormat& format )
+        {
+            for ( int i = m_entries.size() - 1; i >= 0; i-- )
+            {
+                const auto& entry = m_entries[ i ];
+
+                if ( entry.fbo->size() == size && entry.format == format )
+                {
+                    const auto fbo = entry.fbo;
+
+                    m_entries.remove( i );
+                    m_cost -= qskCost( fbo );
+
+                    return fbo;
+                }
+            }
+
+            return new QOpenGLFramebufferObject( size, format );
+        }
+
+        void recycle( QOpenGLFramebufferObject* fbo,
+            const QOpenGLFramebufferObjectFormat& format, qint64 maxCost )
+        {
+            /*
+                The driver might have adjusted the format ( f.e. clamping
+                the number of samples ), so fbo->format() does not need to
+                match the requested one. We remember the requested format
+                to be able to find the fbo again.
+             */
+            m_entries += Entry { format, fbo };
+            m_cost += qskCost( fbo );
+
+            // the least recently used ones are at the beginning
+            while ( m_cost > maxCost && !m_entries.isEmpty() )
+            {
+                const auto oldFbo = m_entries.takeFirst().fbo;
+                m_cost -= qskCost( oldFbo );
+
+                delete oldFbo;
+            }
+        }
+
+      private:
+        static inline qint64 qskCost( const QOpenGLFramebufferObject* fbo )
+        {
+            const auto& format = fbo->format();
+
+            // color + depth/stencil buffers for each sample
+            qint64 cost = qint64( fbo->width() ) * fbo->height() * 4;
+            cost *= qMax( format.samples(), 1 );
+
+            if ( format.attachment() != QOpenGLFramebufferObject::NoAttachment )
+                cost *= 2;
+
+            return cost;
+        }
+
+        struct Entry
+        {
+            QOpenGLFramebufferObjectFormat format;
+            QOpenGLFramebufferObject* fbo;
+        };
+
+        QVector< Entry > m_entries;
+        qint64 m_cost = 0;
+    };
+
+    class FramebufferPoolMap
+    {
+      public:
+        ~FramebufferPoolMap()
+        {
+            qDeleteAll( m_pools );
+        }
+
+        FramebufferPool* pool( QOpenGLContext* context )
+        {
+            QMutexLocker locker( &m_mutex );
+
+            auto pool = m_pools.value( context, nullptr );
+            if ( pool == nullptr )
+            {
+                pool = new FramebufferPool();
+                m_pools.insert( context, pool );
+
+                QObject::connect( context, &QOpenGLContext::aboutToBeDestroyed,
+                    context, [ this, context ] { removePool( context ); },
+                    Qt::DirectConnection );
+            }
+
+            return pool;
+        }
+
+      private:
+        void removePool( const QOpenGLContext* context )
+        {
+            FramebufferPool* pool;
+
+            {
+                QMutexLocker locker( &m_mutex );
+                pool = m_pools.take( context );
+            }
+
+            delete pool;
+        }
+
+        QMutex m_mutex;
+        QHash< const QOpenGLContext*, FramebufferPool* > m_pools;
+    };
+}
+
+Q_GLOBAL_STATIC( FramebufferPoolMap, qskFramebufferPoolMap )
+
 static uint qskCreateTextureOpenGL(
     const QSize& size, QskTextureRenderer::PaintHelper* helper )
 {
+    auto context = QOpenGLContext::currentContext();
+    if ( context == nullptr || qskFramebufferPoolMap.isDestroyed() )
+        return 0;
+
+    auto pool = qskFramebufferPoolMap->pool( context );
+
     const int width = size.width();
     const int height = size.height();
 
@@ -35,9 +178,10 @@ static uint qskCreateTextureOpenGL(
     format1.setAttachment( QOpenGLFramebufferObject::CombinedDepthStencil );
 
     // ### TODO: get samples from window instead
-    format1.setSamples( QOpenGLContext::currentContext()->format().samples() );
+    format1.setSamples( context->format().samples() );
 
-    QOpenGLFramebufferObject multisampledFbo( width, height, format1 );
+    auto multisampledFbo = pool->take( size, format1 );
+    multisampledFbo->bind();
 
     QOpenGLPaintDevice pd( width, height );
     pd.setPaintFlipped( true );
@@ -67,17 +211,29 @@ static uint qskCreateTextureOpenGL(
     QOpenGLFramebufferObjectFormat format2;
     format2.setAttachment( QOpenGLFramebufferObject::NoAttachment );
 
-    QOpenGLFramebufferObject fbo( width, height, format2 );
+    /*
+        After taking the texture of a recycled fbo the
+        next bind() attaches a new one.
+     */
+    auto fbo = pool->take( size, format2 );
+    fbo->bind();
 
     const QRect fboRect( 0, 0, width, height );
 
     QOpenGLFramebufferObject::blitFramebuffer(
-        &fbo, fboRect, &multisampledFbo, fboRect );
+        fbo, fboRect, multisampledFbo, fboRect );
+
+    const auto textureId = fbo->takeTexture();
+
+    const auto maxCost = qskMaxFramebufferCost.loadAcquire();
+
+    pool->recycle( multisampledFbo, format1, maxCost );
+    pool->recycle( fbo, format2, maxCost );
 
-    return fbo.takeTexture();
+    return textureId;
 }
 
-static uint qskCreateTextureRaster(
+static QImage qskCreateImage(
     const QSize& size, QskTextureRenderer::PaintHelper* helper )
 {
     QImage image( size, QImage::Format_RGBA8888_Premultiplied );
@@ -88,6 +244,11 @@ static uint qskCreateTextureRaster(
         helper->paint( &painter, size );
     }
 
+    return image;
+}
+
+static uint qskCreateTextureFromImage( const QImage& image, bool smooth = false )
+{
     const auto target = QOpenGLTexture::Target2D;
 
     auto context = QOpenGLContext::currentContext();
@@ -104,8 +265,10 @@ static uint qskCreateTextureRaster(
 
     f.glBindTexture( target, textureId );
 
-    f.glTexParameteri( target, GL_TEXTURE_MIN_FILTER, QOpenGLTexture::Nearest );
-    f.glTexParameteri( target, GL_TEXTURE_MAG_FILTER, QOpenGLTexture::Nearest );
+    const auto filter = smooth ? QOpenGLTexture::Linear : QOpenGLTexture::Nearest;
+
+    f.glTexParameteri( target, GL_TEXTURE_MIN_FILTER, filter );
+    f.glTexParameteri( target, GL_TEXTURE_MAG_FILTER, filter );
 
     f.glTexParameteri( target, GL_TEXTURE_WRAP_S, QOpenGLTexture::ClampToEdge );
     f.glTexParameteri( target, GL_TEXTURE_WRAP_T, QOpenGLTexture::ClampToEdge );
@@ -131,6 +294,12 @@ static uint qskCreateTextureRaster(
     return textureId;
 }
 
+static uint qskCreateTextureRaster(
+    const QSize& size, QskTextureRenderer::PaintHelper* helper )
+{
+    return qskCreateTextureFromImage( qskCreateImage( size, helper ) );
+}
+
 QSGTexture* QskTextureRenderer::textureFromId(
     QQuickWindow* window, uint textureId, const QSize& size )
 {
@@ -171,6 +340,12 @@ uint QskTextureRenderer::createTexture(
     // Qt6.0.0 is buggy when using FBOs. So let's disable it for the moment TODO ...
     renderMode = Raster;
 #endif
+    if ( renderMode == AsyncRaster )
+    {
+        // we can't wait for a worker thread here
+        renderMode = Raster;
+    }
+
     if ( renderMode == AutoDetect )
     {
         if ( qskSetup->testItemUpdateFlag( QskQuickItem::PreferRasterForTextures ) )
@@ -179,21 +354,20 @@ uint QskTextureRenderer::createTexture(
             renderMode = OpenGL;
     }
 
+    QskNodeStatistics::increment( QskNodeStatistics::TextureUploads );
+
     if ( renderMode == Raster )
         return qskCreateTextureRaster( size, helper );
     else
         return qskCreateTextureOpenGL( size, helper );
 }
 
-uint QskTextureRenderer::createTextureFromGraphic(
-    RenderMode renderMode, const QSize& size,
-    const QskGraphic& graphic, const QskColorFilter& colorFilter,
-    Qt::AspectRatioMode aspectRatioMode )
+namespace
 {
-    class PaintHelper : public QskTextureRenderer::PaintHelper
+    class GraphicHelper : public QskTextureRenderer::PaintHelper
     {
       public:
-        PaintHelper( const QskGraphic& graphic,
+        GraphicHelper( const QskGraphic& graphic,
                 const QskColorFilter& filter, Qt::AspectRatioMode aspectRatioMode )
             : m_graphic( graphic )
             , m_filter( filter )
@@ -204,7 +378,10 @@ uint QskTextureRenderer::createTextureFromGraphic(
         void paint( QPainter* painter, const QSize& size ) override
         {
             const QRect rect( 0, 0, size.width(), size.height() );
-            m_graphic.render( painter, rect, m_filter, m_aspectRatioMode );
+
+            // the substitutions are already applied to the cached graphic
+            const auto graphic = m_graphic.filtered( m_filter );
+            graphic.render( painter, rect, m_aspectRatioMode );
         }
 
       private:
@@ -212,7 +389,85 @@ uint QskTextureRenderer::createTextureFromGraphic(
         const QskColorFilter& m_filter;
         const Qt::AspectRatioMode m_aspectRatioMode;
     };
+}
 
-    PaintHelper helper( graphic, colorFilter, aspectRatioMode );
+uint QskTextureRenderer::createTextureFromGraphic(
+    RenderMode renderMode, const QSize& size,
+    const QskGraphic& graphic, const QskColorFilter& colorFilter,
+    Qt::AspectRatioMode aspectRatioMode )
+{
+    GraphicHelper helper( graphic, colorFilter, aspectRatioMode );
     return createTexture( renderMode, size, &helper );
 }
+
+void QskTextureRenderer::setMaxFramebufferCost( qint64 cost )
+{
+    qskMaxFramebufferCost.storeRelease( qMax( cost, qint64( 0 ) ) );
+}
+
+qint64 QskTextureRenderer::maxFramebufferCost()
+{
+    return qskMaxFramebufferCost.loadAcquire();
+}
+
+QImage QskTextureRenderer::createImage( const QSize& size, PaintHelper* helper )
+{
+    return qskCreateImage( size, helper );
+}
+
+uint QskTextureRenderer::createTextureFromImage( const QImage& image, bool smooth )
+{
+    if ( image.isNull() )
+        return 0;
+
+    QskNodeStatistics::increment( QskNodeStatistics::TextureUploads );
+
+    if ( image.format() != QImage::Format_RGBA8888_Premultiplied )
+    {
+        return qskCreateTextureFromImage(
+            image.convertToFormat( QImage::Format_RGBA8888_Premultiplied ), smooth );
+    }
+
+    return qskCreateTextureFromImage( image, smooth );
+}
+
+void QskTextureRenderer::updateTextureFromImage(
+    uint textureId, const QImage& image, const QRect& rect, const QPoint& pos )
+{
+    auto context = QOpenGLContext::currentContext();
+    if ( textureId == 0 || context == nullptr )
+        return;
+
+    const auto r = rect & image.rect();
+    if ( r.isEmpty() )
+        return;
+
+    QskNodeStatistics::increment( QskNodeStatistics::TextureUploads );
+
+    auto img = image.copy( r );
+    if ( img.format() != QImage::Format_RGBA8888_Premultiplied )
+        img = img.convertToFormat( QImage::Format_RGBA8888_Premultiplied );
+
+    const auto target = QOpenGLTexture::Target2D;
+
+    auto& f = *context->functions();
+
+    GLint oldTexture;
+    f.glGetIntegerv( QOpenGLTexture::BindingTarget2D, &oldTexture );
+
+    f.glBindTexture( target, textureId );
+
+    f.glTexSubImage2D( target, 0, pos.x() + r.x(), pos.y() + r.y(),
+        r.width(), r.height(), QOpenGLTexture::RGBA, QOpenGLTexture::UInt8,
+        img.constBits() );
+
+    f.glBindTexture( target, oldTexture );
+}
+
+QImage QskTextureRenderer::createImageFromGraphic( const QSize& size,
+    const QskGraphic& graphic, const QskColorFilter& colorFilter,
+    Qt::AspectRatioMode aspectRatioMode )
+{
+    GraphicHelper helper( graphic, colorFilter, aspectRatioMode );
+    return qskCreateImage( size, &helper );
+}
@@ -13,6 +13,9 @@ class QskGraphic;
 class QskColorFilter;
 
 class QPainter;
+class QImage;
+class QPoint;
+class QRect;
 class QSize;
 class QSGTexture;
 class QQuickWindow;
@@ -32,7 +35,14 @@ namespace QskTextureRenderer
         AutoDetect, // depends on QskSetup::controlFlags()
 
         Raster,
-        OpenGL
+        OpenGL,
+
+        /*
+            Raster, but painting in a worker thread. Only nodes, that are
+            able to wait for the result ( f.e. QskGraphicNode ) make use of it.
+            Otherwise it is the same as Raster.
+         */
+        AsyncRaster
     };
 
     class QSK_EXPORT PaintHelper
@@ -48,8 +58,33 @@ namespace QskTextureRenderer
         RenderMode, const QSize&, const QskGraphic&,
         const QskColorFilter&, Qt::AspectRatioMode );
 
+    // painting into an image, without uploading it to a texture
+    QSK_EXPORT QImage createImage( const QSize&, PaintHelper* );
+
+    QSK_EXPORT QImage createImageFromGraphic(
+        const QSize&, const QskGraphic&,
+        const QskColorFilter&, Qt::AspectRatioMode );
+
+    // smooth: linear filtering for textures, that are displayed scaled
+    QSK_EXPORT uint createTextureFromImage( const QImage&, bool smooth = false );
+
+    /*
+        uploading a part of the image to a texture. pos is the position
+        of the image inside of the texture, f.e. inside of QskTextureAtlas.
+     */
+    QSK_EXPORT void updateTextureFromImage(
+        uint textureId, const QImage&, const QRect&, const QPoint& pos );
+
     QSK_EXPORT QSGTexture* textureFromId(
         QQuickWindow*, uint textureId, const QSize& );
+
+    /*
+        The framebuffer objects used for the OpenGL mode are kept
+        for being reused, until exceeding this number of bytes.
+        0 disables recycling.
+     */
+    QSK_EXPORT void setMaxFramebufferCost( qint64 );
+    QSK_EXPORT qint64 maxFramebufferCost();
 }
 
 #endif
@@ -0,0 +1,361 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#include "QskVectorGraphicNode.h"
+#include "QskColorFilter.h"
+#include "QskGraphic.h"
+#include "QskPainterCommand.h"
+#include "QskVertex.h"
+
+#include <qglobalstatic.h>
+#include <qmath.h>
+#include <qmatrix4x4.h>
+#include <qpainterpath.h>
+#include <qquickwindow.h>
+#include <qsgvertexcolormaterial.h>
+#include <qvector.h>
+
+QSK_QT_PRIVATE_BEGIN
+#include <private/qtriangulator_p.h>
+QSK_QT_PRIVATE_END
+
+Q_GLOBAL_STATIC( QSGVertexColorMaterial, qskMaterialVertex )
+
+static inline QRgb qskSolidColor( const QBrush& brush )
+{
+    if ( const auto gradient = brush.gradient() )
+    {
+        // gradients are not supported: we take the color in the middle
+        const auto stops = gradient->stops();
+        if ( !stops.isEmpty() )
+            return stops[ stops.size() / 2 ].second.rgba();
+    }
+
+    return brush.color().rgba();
+}
+
+static inline qreal qskLevelOfDetail( qreal scale )
+{
+    /*
+        The curves are flattened according to the scale factor
+        of the node. Using powers of 2 avoids retriangulating, when
+        the size of the node changes only slightly.
+     */
+    if ( scale <= 0.0 )
+        return 1.0;
+
+    return qPow( 2.0, qCeil( std::log2( scale ) ) );
+}
+
+namespace
+{
+    class ColorRun
+    {
+      public:
+        int count;
+
+        QRgb rgb;
+        qreal opacity;
+    };
+
+    class Triangulator
+    {
+      public:
+        Triangulator( qreal levelOfDetail )
+            : m_lod( levelOfDetail )
+        {
+        }
+
+        void append( const QPainterPath& path, const QTransform& transform,
+            QRgb rgb, qreal opacity )
+        {
+            if ( path.isEmpty() || qAlpha( rgb ) == 0 || opacity <= 0.0 )
+                return;
+
+            /*
+                The triangulator works with fixed point coordinates.
+                To have an appropriate precision we triangulate in
+                the scaled coordinate system and scale the vertices back.
+             */
+            const auto matrix = transform * QTransform::fromScale( m_lod, m_lod );
+
+            const auto triangles = qTriangulate( path, matrix, 1.0, true );
+
+            const auto& indices = triangles.indices;
+            const int count = indices.size();
+
+            if ( count == 0 )
+                return;
+
+            if ( !runs.isEmpty() && runs.last().rgb == rgb
+                && runs.last().opacity == opacity )
+            {
+                runs.last().count += count;
+            }
+            else
+            {
+                runs += ColorRun { count, rgb, opacity };
+            }
+
+            const auto& vertices = triangles.vertices;
+            const qreal f = 1.0 / m_lod;
+
+            const int offset = points.size();
+            points.resize( offset + count );
+
+            auto p = points.data() + offset;
+
+            for ( int i = 0; i < count; i++ )
+            {
+                uint index;
+
+                if ( indices.type() == QVertexIndexVector::UnsignedShort )
+                    index = static_cast< const quint16* >( indices.data() )[ i ];
+                else
+                    index = static_cast< const quint32* >( indices.data() )[ i ];
+
+                p[ i ].set( vertices[ 2 * index ] * f, vertices[ 2 * index + 1 ] * f );
+            }
+        }
+
+        QVector< QSGGeometry::Point2D > points;
+        QVector< ColorRun > runs;
+
+      private:
+        const qreal m_lod;
+    };
+}
+
+class QskVectorGraphicNode::PrivateData
+{
+  public:
+    QSGTransformNode* transformNode = nullptr;
+    QSGGeometryNode* geometryNode = nullptr;
+
+    QVector< ColorRun > runs;
+
+    uint graphicHash = 0;
+    uint colorFilterHash = 0;
+
+    qreal levelOfDetail = 0.0;
+};
+
+QskVectorGraphicNode::QskVectorGraphicNode()
+    : m_data( new PrivateData() )
+{
+    auto geometry = new QSGGeometry(
+        QSGGeometry::defaultAttributes_ColoredPoint2D(), 0 );
+    geometry->setDrawingMode( QSGGeometry::DrawTriangles );
+
+    auto node = new QSGGeometryNode();
+    node->setGeometry( geometry );
+    node->setMaterial( qskMaterialVertex );
+    node->setFlag( QSGNode::OwnsGeometry, true );
+
+    /*
+        Some skinlets ( f.e QskListViewSkinlet ) use transform nodes
+        for their own purposes. So we don't expose the matrix and
+        keep the transform node as child.
+     */
+    auto transformNode = new QSGTransformNode();
+    transformNode->appendChildNode( node );
+
+    appendChildNode( transformNode );
+
+    m_data->transformNode = transformNode;
+    m_data->geometryNode = node;
+}
+
+QskVectorGraphicNode::~QskVectorGraphicNode()
+{
+}
+
+bool QskVectorGraphicNode::isSupported( const QskGraphic& graphic )
+{
+    if ( graphic.isNull() )
+        return false;
+
+    return !( graphic.commandTypes() & QskGraphic::RasterData );
+}
+
+void QskVectorGraphicNode::setGraphic( QQuickWindow* window,
+    const QskGraphic& graphic, const QskColorFilter& colorFilter,
+    const QRectF& rect, Qt::Orientations mirrored )
+{
+    const auto br = graphic.boundingRect();
+
+    if ( rect.isEmpty() || br.isEmpty() || !isSupported( graphic ) )
+    {
+        m_data->graphicHash = 0;
+        m_data->runs.clear();
+
+        auto geometry = m_data->geometryNode->geometry();
+        if ( geometry->vertexCount() > 0 )
+        {
+            geometry->allocate( 0 );
+            m_data->geometryNode->markDirty( QSGNode::DirtyGeometry );
+        }
+
+        return;
+    }
+
+    qreal sx = rect.width() / br.width();
+    qreal sy = rect.height() / br.height();
+
+    const qreal ratio = window ? window->effectiveDevicePixelRatio() : 1.0;
+    const auto lod = qskLevelOfDetail( qMax( sx, sy ) * ratio );
+
+    /*
+        Resizing is done by the matrix only. We need to
+        retriangulate, when the curves would become visibly edgy.
+     */
+    const auto graphicHash = graphic.hash( 0 );
+
+    if ( graphicHash != m_data->graphicHash || lod > m_data->levelOfDetail )
+    {
+        updateGeometry( graphic, lod );
+
+        m_data->graphicHash = graphicHash;
+        m_data->levelOfDetail = lod;
+        m_data->colorFilterHash = 0;
+    }
+
+    const auto colorFilterHash = colorFilter.hash( 12000 );
+    if ( colorFilterHash != m_data->colorFilterHash )
+    {
+        updateColors( colorFilter );
+        m_data->colorFilterHash = colorFilterHash;
+    }
+
+    if ( mirrored & Qt::Horizontal )
+        sx = -sx;
+
+    if ( mirrored & Qt::Vertical )
+        sy = -sy;
+
+    QTransform transform;
+    transform.translate( rect.center().x(), rect.center().y() );
+    transform.scale( sx, sy );
+    transform.translate( -br.center().x(), -br.center().y() );
+
+    const QMatrix4x4 m( transform );
+    if ( m != m_data->transformNode->matrix() )
+        m_data->transformNode->setMatrix( m );
+}
+
+void QskVectorGraphicNode::updateGeometry(
+    const QskGraphic& graphic, qreal levelOfDetail )
+{
+    Triangulator triangulator( levelOfDetail );
+
+    QPen pen;
+    QBrush brush;
+    QTransform transform;
+    qreal opacity = 1.0;
+
+    for ( const auto& command : graphic.commands() )
+    {
+        switch ( command.type() )
+        {
+            case QskPainterCommand::State:
+            {
+                const auto data = command.stateData();
+
+                if ( data->flags & QPaintEngine::DirtyPen )
+                    pen = data->pen;
+
+                if ( data->flags & QPaintEngine::DirtyBrush )
+                    brush = data->brush;
+
+                if ( data->flags & QPaintEngine::DirtyTransform )
+                    transform = data->transform;
+
+                if ( data->flags & QPaintEngine::DirtyOpacity )
+                    opacity = data->opacity;
+
+                break;
+            }
+            case QskPainterCommand::Path:
+            {
+                const auto& path = *command.path();
+
+                if ( brush.style() != Qt::NoBrush )
+                {
+                    triangulator.append( path, transform,
+                        qskSolidColor( brush ), opacity );
+                }
+
+                if ( pen.style() != Qt::NoPen && pen.brush().style() != Qt::NoBrush )
+                {
+                    QPainterPathStroker stroker( pen );
+
+                    if ( pen.isCosmetic() )
+                    {
+                        /*
+                            The width of cosmetic pens is in device pixels.
+                            As we don't want to retriangulate for each scale
+                            factor we use the level of detail as approximation.
+                         */
+                        stroker.setWidth(
+                            qMax( pen.widthF(), 1.0 ) / levelOfDetail );
+                    }
+
+                    triangulator.append( stroker.createStroke( path ),
+                        transform, qskSolidColor( pen.brush() ), opacity );
+                }
+
+                break;
+            }
+            default:
+            {
+                // raster data is not supported
+                break;
+            }
+        }
+    }
+
+    auto geometry = m_data->geometryNode->geometry();
+
+    const auto& points = triangulator.points;
+    geometry->allocate( points.size() );
+
+    auto vertices = geometry->vertexDataAsColoredPoint2D();
+    for ( int i = 0; i < points.size(); i++ )
+        vertices[ i ].set( points[ i ].x, points[ i ].y, 0, 0, 0, 0 );
+
+    m_data->runs = triangulator.runs;
+
+    m_data->geometryNode->markDirty( QSGNode::DirtyGeometry );
+}
+
+void QskVectorGraphicNode::updateColors( const QskColorFilter& colorFilter )
+{
+    auto vertices = m_data->geometryNode->geometry()->vertexDataAsColoredPoint2D();
+
+    for ( const auto& run : qskAsConst( m_data->runs ) )
+    {
+        auto rgb = colorFilter.substituted( run.rgb );
+
+        if ( run.opacity < 1.0 )
+        {
+            rgb = qRgba( qRed( rgb ), qGreen( rgb ), qBlue( rgb ),
+                qRound( qAlpha( rgb ) * run.opacity ) );
+        }
+
+        const QskVertex::Color c( rgb );
+
+        for ( int i = 0; i < run.count; i++ )
+        {
+            auto& v = *vertices++;
+
+            v.r = c.r;
+            v.g = c.g;
+            v.b = c.b;
+            v.a = c.a;
+        }
+    }
+
+    m_data->geometryNode->markDirty( QSGNode::DirtyGeometry );
+}
@@ -0,0 +1,50 @@
+/******************************************************************************
+ * QSkinny - Copyright (C) 2016 Uwe Rathmann
+ * This file may be used under the terms of the QSkinny License, Version 1.0
+ *****************************************************************************/
+
+#ifndef QSK_VECTOR_GRAPHIC_NODE_H
+#define QSK_VECTOR_GRAPHIC_NODE_H
+
+#include "QskGlobal.h"
+
+#include <qsgnode.h>
+#include <memory>
+
+class QskGraphic;
+class QskColorFilter;
+class QQuickWindow;
+
+/*
+    QskVectorGraphicNode displays a graphic without rasterizing it:
+    the paths of the graphic are triangulated into a geometry with
+    colored vertices, that is scaled into the target rectangle
+    by the matrix of an internal transform node.
+
+    So resizing the node does not involve any painting and changing
+    the color filter only updates the colors of the vertices.
+
+    Graphics including raster data ( images/pixmaps ) can't be displayed.
+    Clipping and gradients are not supported - gradients are
+    approximated by a solid color.
+ */
+class QSK_EXPORT QskVectorGraphicNode : public QSGNode
+{
+  public:
+    QskVectorGraphicNode();
+    ~QskVectorGraphicNode() override;
+
+    void setGraphic( QQuickWindow*, const QskGraphic&, const QskColorFilter&,
+        const QRectF&, Qt::Orientations mirrored = Qt::Orientations() );
+
+    static bool isSupported( const QskGraphic& );
+
+  private:
+    void updateGeometry( const QskGraphic&, qreal levelOfDetail );
+    void updateColors( const QskColorFilter& );
+
+    class PrivateData;
+    std::unique_ptr< PrivateData > m_data;
+};
+
+#endif
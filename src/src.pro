@@ -68,6 +68,8 @@ HEADERS += \
     graphic/QskGraphicProvider.h \
     graphic/QskGraphicProviderMap.h \
     graphic/QskGraphicTextureFactory.h \
+    graphic/QskIconPack.h \
+    graphic/QskIconPackProvider.h \
     graphic/QskPainterCommand.h \
     graphic/QskStandardSymbol.h
 
@@ -80,44 +82,65 @@ SOURCES += \
     graphic/QskGraphicProvider.cpp \
     graphic/QskGraphicProviderMap.cpp \
     graphic/QskGraphicTextureFactory.cpp \
+    graphic/QskIconPack.cpp \
+    graphic/QskIconPackProvider.cpp \
     graphic/QskPainterCommand.cpp \
     graphic/QskStandardSymbol.cpp
 
 HEADERS += \
     nodes/QskBoxNode.h \
     nodes/QskBoxClipNode.h \
+    nodes/QskBoxShadowNode.h \
     nodes/QskBoxRenderer.h \
     nodes/QskBoxRendererColorMap.h \
+    nodes/QskGradientTexture.h \
     nodes/QskGraphicNode.h \
+    nodes/QskMergedBoxNode.h \
+    nodes/QskNodePool.h \
+    nodes/QskNodeStatistics.h \
     nodes/QskPaintedNode.h \
     nodes/QskPlainTextRenderer.h \
     nodes/QskRichTextRenderer.h \
     nodes/QskScaleRenderer.h \
     nodes/QskSGNode.h \
+    nodes/QskSoftwareBoxNode.h \
     nodes/QskTextNode.h \
     nodes/QskTextRenderer.h \
+    nodes/QskTextureAtlas.h \
+    nodes/QskTextureCache.h \
     nodes/QskTextureNode.h \
     nodes/QskTextureRenderer.h \
     nodes/QskTickmarksNode.h \
+    nodes/QskVectorGraphicNode.h \
     nodes/QskVertex.h
 
 SOURCES += \
     nodes/QskBoxNode.cpp \
     nodes/QskBoxClipNode.cpp \
+    nodes/QskBoxShadowNode.cpp \
     nodes/QskBoxRendererRect.cpp \
     nodes/QskBoxRendererEllipse.cpp \
     nodes/QskBoxRendererDEllipse.cpp \
+    nodes/QskBoxRendererIndexed.cpp \
+    nodes/QskGradientTexture.cpp \
     nodes/QskGraphicNode.cpp \
+    nodes/QskMergedBoxNode.cpp \
+    nodes/QskNodePool.cpp \
+    nodes/QskNodeStatistics.cpp \
     nodes/QskPaintedNode.cpp \
     nodes/QskPlainTextRenderer.cpp \
     nodes/QskRichTextRenderer.cpp \
     nodes/QskScaleRenderer.cpp \
     nodes/QskSGNode.cpp \
+    nodes/QskSoftwareBoxNode.cpp \
     nodes/QskTextNode.cpp \
     nodes/QskTextRenderer.cpp \
+    nodes/QskTextureAtlas.cpp \
+    nodes/QskTextureCache.cpp \
     nodes/QskTextureNode.cpp \
     nodes/QskTextureRenderer.cpp \
     nodes/QskTickmarksNode.cpp \
+    nodes/QskVectorGraphicNode.cpp \
     nodes/QskVertex.cpp
 
 HEADERS += \
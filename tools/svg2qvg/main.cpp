@@ -10,9 +10,11 @@
 #include <QskPainterCommand.cpp>
 #include <QskGraphicPaintEngine.cpp>
 #include <QskGraphicIO.cpp>
+#include <QskIconPack.cpp>
 #else
 #include <QskGraphicIO.h>
 #include <QskGraphic.h>
+#include <QskIconPack.h>
 #endif
 
 #include <QGuiApplication>
@@ -20,13 +22,448 @@
 #include <QPainter>
 #include <QDebug>
 
+#include <QAtomicInt>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <QThreadPool>
+
+namespace
+{
+    class Options
+    {
+      public:
+        QskGraphicIO::Format format = QskGraphicIO::StreamFormat;
+
+        bool optimize = false;
+        qreal tolerance = 0.0;
+
+        // an icon pack with all converted graphics of a batch
+        QString packFile;
+
+        // a different stamp makes all files of a batch being converted again
+        QByteArray stamp() const
+        {
+            return QByteArray::number( format ) + '/'
+                + QByteArray::number( optimize ) + '/'
+                + QByteArray::number( tolerance );
+        }
+    };
+}
+
 static void usage( const char* appName )
 {
-    qWarning() << "usage: " << appName << "svgfile qvgfile";
+    qWarning() << "usage: " << appName
+        << "[-mapped] [-optimize] [-tolerance value] svgfile qvgfile";
+
+    qWarning() << "       " << appName
+        << "[-mapped] [-optimize] [-tolerance value] [-jobs n] [-pack file]"
+        << "-batch svgdir qvgdir";
+}
+
+static bool convert( const QString& svgFile,
+    const QString& qvgFile, const Options& options )
+{
+    QSvgRenderer renderer;
+    if ( !renderer.load( svgFile ) )
+        return false;
+
+    QskGraphic graphic;
+
+    QPainter painter( &graphic );
+    renderer.render( &painter );
+    painter.end();
+
+    if ( graphic.commandTypes() & QskGraphic::RasterData )
+        qWarning() << svgFile << "contains non scalable parts.";
+
+    if ( options.optimize )
+        graphic.optimize( options.tolerance );
+
+    return QskGraphicIO::write( graphic, qvgFile, options.format );
+}
+
+namespace
+{
+    /*
+        To skip unchanged files we remember size, modification time
+        and a hash of the content of each converted SVG. The hash is only
+        calculated, when size or modification time have changed.
+     */
+    class StampFile
+    {
+      public:
+        class Stamp
+        {
+          public:
+            qint64 size = -1;
+            qint64 modificationTime = -1;
+            QByteArray hash;
+        };
+
+        StampFile( const QString& fileName, const QByteArray& optionsStamp )
+            : m_fileName( fileName )
+            , m_optionsStamp( optionsStamp )
+        {
+            QFile file( fileName );
+            if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+                return;
+
+            // the first line are the options, the stamps are obsolete when they differ
+            if ( file.readLine().trimmed() != optionsStamp )
+                return;
+
+            while ( !file.atEnd() )
+            {
+                const auto values = file.readLine().trimmed().split( '\t' );
+                if ( values.size() != 4 )
+                    continue;
+
+                Stamp stamp;
+                stamp.size = values[ 1 ].toLongLong();
+                stamp.modificationTime = values[ 2 ].toLongLong();
+                stamp.hash = values[ 3 ];
+
+                m_stamps.insert( QString::fromUtf8( values[ 0 ] ), stamp );
+            }
+        }
+
+        Stamp stamp( const QString& path ) const
+        {
+            QMutexLocker locker( &m_mutex );
+            return m_stamps.value( path );
+        }
+
+        void setStamp( const QString& path, const Stamp& stamp )
+        {
+            QMutexLocker locker( &m_mutex );
+            m_stamps.insert( path, stamp );
+        }
+
+        // removes the stamps of SVGs, that are gone, and returns their paths
+        QStringList prune( const QSet< QString >& paths )
+        {
+            QMutexLocker locker( &m_mutex );
+
+            QStringList removedPaths;
+
+            for ( auto it = m_stamps.begin(); it != m_stamps.end(); )
+            {
+                if ( paths.contains( it.key() ) )
+                {
+                    ++it;
+                }
+                else
+                {
+                    removedPaths += it.key();
+                    it = m_stamps.erase( it );
+                }
+            }
+
+            return removedPaths;
+        }
+
+        bool save() const
+        {
+            QSaveFile file( m_fileName );
+            if ( !file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+                return false;
+
+            QTextStream stream( &file );
+            stream << m_optionsStamp << "\n";
+
+            for ( auto it = m_stamps.constBegin(); it != m_stamps.constEnd(); ++it )
+            {
+                const auto& stamp = it.value();
+
+                stream << it.key() << '\t' << stamp.size << '\t'
+                    << stamp.modificationTime << '\t' << stamp.hash << "\n";
+            }
+
+            stream.flush();
+            return file.commit();
+        }
+
+      private:
+        const QString m_fileName;
+        const QByteArray m_optionsStamp;
+
+        mutable QMutex m_mutex;
+        QHash< QString, Stamp > m_stamps;
+    };
+
+    class Batch
+    {
+      public:
+        QAtomicInt converted;
+        QAtomicInt skipped;
+        QAtomicInt failed;
+    };
+
+    class ConvertJob : public QRunnable
+    {
+      public:
+        ConvertJob( const QString& svgFile, const QString& path,
+                const QString& qvgFile, const Options& options,
+                StampFile& stampFile, Batch& batch )
+            : m_svgFile( svgFile )
+            , m_path( path )
+            , m_qvgFile( qvgFile )
+            , m_options( options )
+            , m_stampFile( stampFile )
+            , m_batch( batch )
+        {
+        }
+
+        void run() override
+        {
+            QElapsedTimer timer;
+            timer.start();
+
+            const QFileInfo info( m_svgFile );
+
+            StampFile::Stamp stamp;
+            stamp.size = info.size();
+            stamp.modificationTime = info.lastModified().toMSecsSinceEpoch();
+
+            const auto oldStamp = m_stampFile.stamp( m_path );
+            const bool hasOutput = QFileInfo::exists( m_qvgFile );
+
+            if ( hasOutput && oldStamp.size == stamp.size
+                && oldStamp.modificationTime == stamp.modificationTime )
+            {
+                m_batch.skipped.ref();
+                return;
+            }
+
+            stamp.hash = contentHash();
+
+            if ( hasOutput && !stamp.hash.isEmpty() && stamp.hash == oldStamp.hash )
+            {
+                // touched, but not modified
+                m_stampFile.setStamp( m_path, stamp );
+                m_batch.skipped.ref();
+
+                return;
+            }
+
+            QDir().mkpath( QFileInfo( m_qvgFile ).absolutePath() );
+
+            if ( !convert( m_svgFile, m_qvgFile, m_options ) )
+            {
+                qWarning() << "failed:" << m_path;
+                m_batch.failed.ref();
+
+                return;
+            }
+
+            m_stampFile.setStamp( m_path, stamp );
+            m_batch.converted.ref();
+
+            qDebug().noquote() << QStringLiteral( "%1 ms" ).arg(
+                timer.elapsed(), 6 ) << m_path;
+        }
+
+      private:
+        QByteArray contentHash() const
+        {
+            QFile file( m_svgFile );
+            if ( !file.open( QIODevice::ReadOnly ) )
+                return QByteArray();
+
+            QCryptographicHash hash( QCryptographicHash::Sha1 );
+            hash.addData( &file );
+
+            return hash.result().toHex();
+        }
+
+        const QString m_svgFile;
+        const QString m_path;
+        const QString m_qvgFile;
+        const Options m_options;
+
+        StampFile& m_stampFile;
+        Batch& m_batch;
+    };
+}
+
+static inline QString qskQvgPath( const QString& svgPath )
+{
+    auto path = svgPath;
+    path.replace( path.length() - 3, 3, QStringLiteral( "qvg" ) );
+
+    return path;
+}
+
+static bool writePack( const QDir& qvgDir,
+    const QStringList& paths, const QString& packFile )
+{
+    QList< QPair< QString, QByteArray > > graphics;
+
+    for ( const auto& path : paths )
+    {
+        QFile file( qvgDir.filePath( qskQvgPath( path ) ) );
+        if ( !file.exists() )
+            continue; // failed
+
+        if ( !file.open( QIODevice::ReadOnly ) )
+            return false;
+
+        auto name = path;
+        name.chop( 4 ); // ".svg"
+
+        graphics += qMakePair( name, file.readAll() );
+    }
+
+    return QskIconPack::write( packFile, graphics );
+}
+
+static int convertBatch( const QString& svgDir,
+    const QString& qvgDir, const Options& options, int jobs )
+{
+    const QDir inDir( svgDir );
+    if ( !inDir.exists() )
+    {
+        qWarning() << svgDir << "is not a directory.";
+        return -1;
+    }
+
+    const QDir outDir( qvgDir );
+    QDir().mkpath( outDir.absolutePath() );
+
+    StampFile stampFile( outDir.filePath( ".svg2qvg.stamps" ), options.stamp() );
+
+    Batch batch;
+
+    QThreadPool pool;
+    if ( jobs > 0 )
+        pool.setMaxThreadCount( jobs );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // the SVGs of this batch, relative to svgDir
+    QStringList paths;
+
+    QDirIterator it( svgDir, QStringList() << "*.svg",
+        QDir::Files, QDirIterator::Subdirectories );
+
+    while ( it.hasNext() )
+    {
+        const auto svgFile = it.next();
+        const auto path = inDir.relativeFilePath( svgFile );
+
+        const auto qvgFile = outDir.filePath( qskQvgPath( path ) );
+
+        pool.start( new ConvertJob( svgFile, path,
+            qvgFile, options, stampFile, batch ) );
+
+        paths += path;
+    }
+
+    pool.waitForDone();
+
+    paths.sort();
+
+    /*
+        The outputs of SVGs, that have been removed or renamed
+        since the previous run, are stale and removed as well.
+     */
+    QSet< QString > pathSet;
+    for ( const auto& path : qskAsConst( paths ) )
+        pathSet += path;
+
+    const auto stalePaths = stampFile.prune( pathSet );
+
+    for ( const auto& path : stalePaths )
+        QFile::remove( outDir.filePath( qskQvgPath( path ) ) );
+
+    if ( !stampFile.save() )
+        qWarning() << "can't write the stamps to" << qvgDir;
+
+    if ( !options.packFile.isEmpty() )
+    {
+        if ( !writePack( outDir, paths, options.packFile ) )
+        {
+            qWarning() << "can't write the icon pack" << options.packFile;
+            return -2;
+        }
+    }
+
+    qDebug().noquote() << QStringLiteral( "%1 converted, %2 skipped, %3 failed in %4 ms" )
+        .arg( batch.converted.loadAcquire() ).arg( batch.skipped.loadAcquire() )
+        .arg( batch.failed.loadAcquire() ).arg( timer.elapsed() );
+
+    return ( batch.failed.loadAcquire() > 0 ) ? -2 : 0;
 }
 
 int main( int argc, char* argv[] )
 {
+    Options options;
+
+    bool batchMode = false;
+    int jobs = 0;
+
+    while ( argc > 3 && argv[1][0] == '-' )
+    {
+        int n = 1;
+
+        if ( qstrcmp( argv[1], "-mapped" ) == 0 )
+        {
+            // the memory mappable format
+            options.format = QskGraphicIO::MappedFormat;
+        }
+        else if ( qstrcmp( argv[1], "-optimize" ) == 0 )
+        {
+            options.optimize = true;
+        }
+        else if ( qstrcmp( argv[1], "-tolerance" ) == 0 && argc > 4 )
+        {
+            // implies -optimize
+            options.optimize = true;
+            options.tolerance = qMax( QByteArray( argv[2] ).toDouble(), 0.0 );
+
+            n = 2;
+        }
+        else if ( qstrcmp( argv[1], "-batch" ) == 0 )
+        {
+            // converting all SVGs below svgdir
+            batchMode = true;
+        }
+        else if ( qstrcmp( argv[1], "-pack" ) == 0 && argc > 4 )
+        {
+            // collecting the converted graphics in an icon pack
+            options.packFile = QString::fromLocal8Bit( argv[2] );
+            n = 2;
+        }
+        else if ( qstrcmp( argv[1], "-jobs" ) == 0 && argc > 4 )
+        {
+            jobs = QByteArray( argv[2] ).toInt();
+            n = 2;
+        }
+        else
+        {
+            usage( argv[0] );
+            return -1;
+        }
+
+        for ( int i = 0; i < n; i++ )
+        {
+            argv[1] = argv[0];
+            argc--;
+            argv++;
+        }
+    }
+
     if ( argc != 3 )
     {
         usage( argv[0] );
@@ -51,21 +488,11 @@ int main( int argc, char* argv[] )
     QGuiApplication app( argc, argv );
 #endif
 
-    QSvgRenderer renderer;
-    if ( !renderer.load( QString( argv[1] ) ) )
-        return -2;
-
-    QskGraphic graphic;
-
-    QPainter painter( &graphic );
-    renderer.render( &painter );
-    painter.end();
-
-    if ( graphic.commandTypes() & QskGraphic::RasterData )
-        qWarning() << argv[1] << "contains non scalable parts.";
+    if ( batchMode )
+        return convertBatch( argv[1], argv[2], options, jobs );
 
-    QskGraphicIO::write( graphic, argv[2] );
+    if ( !convert( argv[1], argv[2], options ) )
+        return -2;
 
     return 0;
 }
-